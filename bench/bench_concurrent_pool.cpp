@@ -0,0 +1,77 @@
+#include "concurrent_pool.hpp"
+#include "pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Entity {
+    float position[3];
+    float velocity[3];
+    int   id;
+
+    Entity(int p_id = 0) : position{0, 0, 0}, velocity{1, 1, 1}, id(p_id) {}
+};
+
+using Clock = std::chrono::steady_clock;
+
+const std::size_t opsPerThread = 1000000;
+const std::size_t batch        = 32;
+
+// Each thread holds `batch` objects at a time, then releases them all.
+template<typename TAcquire>
+double run(std::size_t threadCount, TAcquire acquireBatch) {
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for (std::size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&acquireBatch]() {
+            for (std::size_t done = 0; done < opsPerThread; done += batch) {
+                acquireBatch();
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    auto end = Clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(threadCount * opsPerThread) / seconds / 1e6;
+}
+
+int main() {
+    std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    Pool<Entity> lockedPool(1024);
+    std::mutex lockedPoolMutex;
+    ConcurrentPool<Entity> concurrentPool;
+
+    std::cout << "acquire+release Mops/s, batches of " << batch << std::endl;
+    std::cout << "threads  Pool+mutex  ConcurrentPool" << std::endl;
+
+    for (std::size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        double locked = run(threadCount, [&]() {
+            std::vector<Pool<Entity>::Object> held;
+            held.reserve(batch);
+            for (std::size_t i = 0; i < batch; ++i) {
+                std::lock_guard<std::mutex> lock(lockedPoolMutex);
+                held.push_back(lockedPool.acquire(static_cast<int>(i)));
+            }
+            std::lock_guard<std::mutex> lock(lockedPoolMutex);
+            held.clear();
+        });
+
+        double concurrent = run(threadCount, [&]() {
+            std::vector<ConcurrentPool<Entity>::Object> held;
+            held.reserve(batch);
+            for (std::size_t i = 0; i < batch; ++i) {
+                held.push_back(concurrentPool.acquire(static_cast<int>(i)));
+            }
+        });
+
+        std::cout << threadCount << "\t " << locked << "\t     " << concurrent << std::endl;
+        if (threadCount * 2 > maxThreads && threadCount != maxThreads) threadCount = maxThreads / 2;
+    }
+
+    return 0;
+}
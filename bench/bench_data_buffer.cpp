@@ -0,0 +1,56 @@
+#include "data_buffer.hpp"
+#include <chrono>
+#include <iostream>
+#include <istream>
+#include <ostream>
+
+// Only knows how to print itself, so DataBuffer has to go through iostreams.
+struct StreamedInt {
+    int value;
+    StreamedInt(int v = 0) : value(v) {}
+    StreamedInt(const StreamedInt& other) : value(other.value) {}
+
+    friend std::ostream& operator<<(std::ostream& os, const StreamedInt& s) { return os << s.value; }
+    friend std::istream& operator>>(std::istream& is, StreamedInt& s) { return is >> s.value; }
+};
+
+int valueOf(int v) { return v; }
+int valueOf(const StreamedInt& s) { return s.value; }
+
+template<typename TField>
+void run(const char* label, std::size_t fields) {
+    using Clock = std::chrono::steady_clock;
+
+    DataBuffer buffer;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < fields; ++i) {
+        buffer << TField(static_cast<int>(i));
+    }
+    auto encoded = Clock::now();
+
+    long long checksum = 0;
+    TField field;
+    for (std::size_t i = 0; i < fields; ++i) {
+        buffer >> field;
+        checksum += valueOf(field);
+    }
+    auto decoded = Clock::now();
+
+    double encNs = std::chrono::duration<double, std::nano>(encoded - start).count() / fields;
+    double decNs = std::chrono::duration<double, std::nano>(decoded - encoded).count() / fields;
+
+    std::cout << label
+              << "  encode " << encNs << " ns/field"
+              << "  decode " << decNs << " ns/field"
+              << "  " << static_cast<double>(buffer.size()) / fields << " bytes/field"
+              << "  (checksum " << checksum << ")" << std::endl;
+}
+
+int main() {
+    const std::size_t fields = 1000000;
+
+    run<int>("binary int  ", fields);
+    run<StreamedInt>("stream int  ", fields);
+
+    return 0;
+}
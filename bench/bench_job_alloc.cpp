@@ -0,0 +1,90 @@
+#include "worker_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+const int jobs       = 200000;
+const int roundTrips = 20000;
+
+std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// Captures 40 bytes: too big for std::function's small buffer, small enough
+// to be stored inline by WorkerPool::IJob.
+struct Payload {
+    std::atomic<int>* counter;
+    uint64_t          a, b, c, d;
+};
+
+template<bool TWrapped>
+void submit(WorkerPool& pool, Payload p) {
+    auto job = [p]() {
+        p.counter->fetch_add(static_cast<int>((p.a + p.b + p.c + p.d) & 1), std::memory_order_relaxed);
+    };
+    if constexpr (TWrapped) {
+        pool.addJob(std::function<void()>(job));
+    } else {
+        pool.addJob(job);
+    }
+}
+
+template<bool TWrapped>
+double allocationsPerJob(WorkerPool::Scheduling scheduling) {
+    WorkerPool pool(2, scheduling);
+    std::atomic<int> done{0};
+
+    // Warm up so queue storage and pooled job nodes already exist.
+    for (int i = 0; i < jobs; ++i) submit<TWrapped>(pool, {&done, 1, 0, 0, 0});
+    while (done.load() < jobs) std::this_thread::yield();
+
+    done = 0;
+    std::size_t before = allocations.load();
+    for (int i = 0; i < jobs; ++i) submit<TWrapped>(pool, {&done, 1, 0, 0, 0});
+    while (done.load() < jobs) std::this_thread::yield();
+    return static_cast<double>(allocations.load() - before) / jobs;
+}
+
+// Average time from addJob() on this thread to the job running on a worker.
+template<bool TWrapped>
+double latencyNs(WorkerPool::Scheduling scheduling) {
+    WorkerPool pool(1, scheduling);
+    std::atomic<int> done{0};
+
+    auto start = Clock::now();
+    for (int i = 0; i < roundTrips; ++i) {
+        submit<TWrapped>(pool, {&done, 1, 0, 0, 0});
+        while (done.load(std::memory_order_acquire) <= i) std::this_thread::yield();
+    }
+    auto end = Clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / roundTrips;
+}
+
+void report(const char* name, WorkerPool::Scheduling scheduling) {
+    std::cout << name << std::endl;
+    std::cout << "  std::function  " << allocationsPerJob<true>(scheduling) << " allocs/job, "
+              << latencyNs<true>(scheduling) << " ns submit-to-run" << std::endl;
+    std::cout << "  inline lambda  " << allocationsPerJob<false>(scheduling) << " allocs/job, "
+              << latencyNs<false>(scheduling) << " ns submit-to-run" << std::endl;
+}
+
+int main() {
+    std::cout << "job capture " << sizeof(Payload) << " bytes, inline capacity "
+              << WorkerPool::IJob::capacity << " bytes" << std::endl;
+    report("SharedQueue", WorkerPool::Scheduling::SharedQueue);
+    report("WorkStealing", WorkerPool::Scheduling::WorkStealing);
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "binary_log.hpp"
+#include <chrono>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+const int linesPerThread = 100000;
+
+// Nanoseconds per statement as seen by the logging threads.
+template<bool TDeferred>
+double run(std::size_t threads) {
+    std::vector<std::thread> pool;
+    auto start = Clock::now();
+    for (std::size_t t = 0; t < threads; ++t) {
+        pool.emplace_back([t]() {
+            threadSafeCout.setPrefix("[worker " + std::to_string(t) + "] ");
+            for (int i = 0; i < linesPerThread; ++i) {
+                if constexpr (TDeferred) {
+                    THREAD_SAFE_LOG("request {} served in {} us", i, 42);
+                } else {
+                    threadSafeCout << "request " << i << " served in " << 42 << " us" << std::endl;
+                }
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    auto end = Clock::now();
+    BinaryLog::instance().flush();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (linesPerThread * threads);
+}
+
+int main() {
+    // Log lines go to /dev/null, results to the original stdout.
+    int results = ::dup(STDOUT_FILENO);
+    int null = ::open("/dev/null", O_WRONLY);
+    ::dup2(null, STDOUT_FILENO);
+
+    std::size_t threads = std::max(2u, std::thread::hardware_concurrency());
+    double sync = run<false>(threads);
+
+    LogWriter::instance().enableAsync();
+    double async = run<false>(threads);
+
+    BinaryLog::instance().start();
+    double deferred = run<true>(threads);
+    BinaryLog::instance().stop();
+
+    BinaryLog::Options options;
+    options.output = BinaryLog::Output::Binary;
+    options.fd = null;
+    BinaryLog::instance().start(options);
+    double binary = run<true>(threads);
+    BinaryLog::instance().stop();
+    LogWriter::instance().disableAsync();
+
+    std::string report = std::to_string(threads) + " threads, " + std::to_string(linesPerThread) + " lines each\n"
+        + "synchronous  " + std::to_string(sync) + " ns/line\n"
+        + "async        " + std::to_string(async) + " ns/line\n"
+        + "deferred     " + std::to_string(deferred) + " ns/line (formatted by the consumer)\n"
+        + "binary       " + std::to_string(binary) + " ns/line (raw records to file)\n";
+    ssize_t written = ::write(results, report.data(), report.size());
+    (void)written;
+    return 0;
+}
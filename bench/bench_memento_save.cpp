@@ -0,0 +1,87 @@
+#include "memento.hpp"
+#include "worker_pool.hpp"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+const std::size_t cells = 4 * 1024 * 1024;
+const int saves = 10;
+
+class World : public Memento {
+    friend class Memento;
+
+public:
+    CopyOnWrite<std::vector<int>> cells_{std::vector<int>(cells)};
+
+    World(void) {
+        std::vector<int>& c = cells_.write();
+        for (std::size_t i = 0; i < c.size(); ++i) c[i] = static_cast<int>(i / 64 % 1000);
+    }
+
+private:
+    void _saveToSnapshot(Snapshot& snapshotToFill) const override {
+        write(snapshotToFill, *cells_);
+    }
+
+    void _loadFromSnapshot(Snapshot& snapshot) override {
+        std::vector<int>& c = cells_.write();
+        for (int& v : c) snapshot >> v;
+    }
+
+    Capture _captureForSave() const override {
+        std::shared_ptr<const std::vector<int>> captured = cells_.share();
+        return [captured](Snapshot& out) { write(out, *captured); };
+    }
+
+    static void write(Snapshot& out, const std::vector<int>& c) {
+        for (int v : c) out << v;
+    }
+};
+
+double ms(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+int main() {
+    WorkerPool pool(1);
+    World world;
+
+    // Time the calling thread is blocked per checkpoint
+    Clock::duration sync{0};
+    for (int i = 0; i < saves; ++i) {
+        auto start = Clock::now();
+        Memento::Snapshot s = world.save();
+        sync += Clock::now() - start;
+    }
+
+    Clock::duration async{0};
+    std::size_t raw = 0;
+    std::size_t packed = 0;
+    for (int i = 0; i < saves; ++i) {
+        auto start = Clock::now();
+        auto pending = world.saveAsync(pool, Memento::Compression::Fast);
+        world.cells_.write()[i] = i;    // first write after a capture copies
+        async += Clock::now() - start;
+        packed = pending.get().size();
+    }
+    raw = world.save().size();
+
+    Memento::Snapshot full = world.save();
+    auto start = Clock::now();
+    Memento::Snapshot compressed = Memento::compress(full);
+    auto middle = Clock::now();
+    Memento::Snapshot expanded = Memento::decompress(compressed);
+    auto end = Clock::now();
+
+    double mb = raw / (1024.0 * 1024.0);
+    std::cout << "state " << mb << " MiB, " << saves << " checkpoints" << std::endl;
+    std::cout << "save()        " << ms(sync) / saves << " ms blocked per checkpoint" << std::endl;
+    std::cout << "saveAsync()   " << ms(async) / saves << " ms blocked per checkpoint (capture + COW copy)" << std::endl;
+    std::cout << "compression   " << static_cast<double>(raw) / packed << "x, "
+              << mb / (ms(middle - start) / 1000) << " MiB/s in, "
+              << mb / (ms(end - middle) / 1000) << " MiB/s out" << std::endl;
+    std::cout << "(check " << (expanded.size() == raw ? "ok" : "mismatch") << ")" << std::endl;
+    return 0;
+}
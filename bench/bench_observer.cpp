@@ -0,0 +1,58 @@
+#include "observer.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using Clock = std::chrono::steady_clock;
+
+enum class Event {
+    Moved,
+    Hit,
+    Died,
+    Spawned
+};
+
+struct Position {
+    float x, y, z;
+};
+
+const int subscribers   = 8;
+const int notifications = 1000000;
+
+std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main() {
+    Observer<Event, Position> bus;
+    double sum = 0;
+    for (int i = 0; i < subscribers; ++i) {
+        bus.subscribe(Event::Moved, [&sum, i](const Position& p) { sum += p.x * i + p.y - p.z; });
+    }
+
+    std::size_t before = allocations.load();
+    auto start = Clock::now();
+    for (int n = 0; n < notifications; ++n) {
+        Position p{static_cast<float>(n), 1.0f, 2.0f};
+        bus.notify(Event::Moved, p);
+        bus.notify(Event::Died, p);   // no subscribers
+    }
+    auto end = Clock::now();
+    std::size_t allocated = allocations.load() - before;
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / notifications;
+    std::cout << notifications << " notifications to " << subscribers << " subscribers (+1 unsubscribed event)" << std::endl;
+    std::cout << "notify       " << ns << " ns" << std::endl;
+    std::cout << "allocations  " << allocated << std::endl;
+    std::cout << "(checksum " << sum << ")" << std::endl;
+    return 0;
+}
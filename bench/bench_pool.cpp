@@ -0,0 +1,116 @@
+#include "pool.hpp"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+struct Entity {
+    float position[3];
+    float velocity[3];
+    int   id;
+
+    Entity(int p_id = 0) : position{0, 0, 0}, velocity{1, 1, 1}, id(p_id) {}
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the compiler from eliding allocations whose result is never used.
+inline void escape(void* p) {
+    asm volatile("" : : "g"(p) : "memory");
+}
+
+const std::size_t capacity = 100000;
+const std::size_t rounds   = 1000000;
+
+template<bool TAligned>
+double benchPool(std::size_t fill) {
+    Pool<Entity, TAligned> pool;
+    pool.resize(capacity);
+
+    std::vector<typename Pool<Entity, TAligned>::Object> held;
+    held.reserve(fill);
+    for (std::size_t i = 0; i < fill; ++i) {
+        held.emplace_back(pool.acquire(static_cast<int>(i)));
+    }
+
+    long long checksum = 0;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < rounds; ++i) {
+        auto obj = pool.acquire(static_cast<int>(i));
+        escape(&*obj);
+        checksum += obj->id;
+    }
+    auto end = Clock::now();
+
+    escape(&checksum);
+    return std::chrono::duration<double, std::nano>(end - start).count() / rounds;
+}
+
+double benchNew(std::size_t fill) {
+    std::vector<std::unique_ptr<Entity>> held;
+    held.reserve(fill);
+    for (std::size_t i = 0; i < fill; ++i) {
+        held.emplace_back(new Entity(static_cast<int>(i)));
+    }
+
+    long long checksum = 0;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < rounds; ++i) {
+        Entity* obj = new Entity(static_cast<int>(i));
+        escape(obj);
+        checksum += obj->id;
+        delete obj;
+    }
+    auto end = Clock::now();
+
+    escape(&checksum);
+    return std::chrono::duration<double, std::nano>(end - start).count() / rounds;
+}
+
+double benchAllocator(std::size_t fill) {
+    std::allocator<Entity> alloc;
+    using Traits = std::allocator_traits<std::allocator<Entity>>;
+
+    std::vector<Entity*> held;
+    held.reserve(fill);
+    for (std::size_t i = 0; i < fill; ++i) {
+        Entity* e = Traits::allocate(alloc, 1);
+        Traits::construct(alloc, e, static_cast<int>(i));
+        held.push_back(e);
+    }
+
+    long long checksum = 0;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < rounds; ++i) {
+        Entity* obj = Traits::allocate(alloc, 1);
+        Traits::construct(alloc, obj, static_cast<int>(i));
+        escape(obj);
+        checksum += obj->id;
+        Traits::destroy(alloc, obj);
+        Traits::deallocate(alloc, obj, 1);
+    }
+    auto end = Clock::now();
+
+    for (Entity* e : held) {
+        Traits::destroy(alloc, e);
+        Traits::deallocate(alloc, e, 1);
+    }
+    escape(&checksum);
+    return std::chrono::duration<double, std::nano>(end - start).count() / rounds;
+}
+
+int main() {
+    std::cout << "acquire+release ns/op, capacity " << capacity << std::endl;
+    std::cout << "fill   pool     pool(aligned)  new/delete  std::allocator" << std::endl;
+
+    for (int percent : {0, 50, 90, 99}) {
+        std::size_t fill = capacity * percent / 100;
+        std::cout << percent << "%\t"
+                  << benchPool<false>(fill) << "\t"
+                  << benchPool<true>(fill) << "\t\t"
+                  << benchNew(fill) << "\t\t"
+                  << benchAllocator(fill) << std::endl;
+    }
+
+    return 0;
+}
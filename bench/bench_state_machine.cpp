@@ -0,0 +1,63 @@
+#include "state_machine.hpp"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+enum class State {
+    Idle,
+    Walking,
+    Running,
+    Jumping,
+    Falling,
+    Attacking,
+    Hurt,
+    Dead
+};
+
+const int stateCount = 8;
+const int machineCount = 10000;
+const int ticks = 200;
+
+std::vector<StateMachine<State>> makeMachines(long long& counter) {
+    std::vector<StateMachine<State>> machines(machineCount);
+    for (auto& sm : machines) {
+        for (int s = 0; s < stateCount; ++s) {
+            sm.addState(static_cast<State>(s));
+            sm.addAction(static_cast<State>(s), [&counter, s]() { counter += s; });
+            int next = (s + 1) % stateCount;
+            sm.addTransition(static_cast<State>(s), static_cast<State>(next), [&counter]() { ++counter; });
+        }
+    }
+    return machines;
+}
+
+// Nanoseconds per update() + transitionTo() pair, over every machine.
+double run(bool compiled, long long& counter) {
+    std::vector<StateMachine<State>> machines = makeMachines(counter);
+    if (compiled) {
+        for (auto& sm : machines) sm.compile();
+    }
+    auto start = Clock::now();
+    for (int t = 0; t < ticks; ++t) {
+        State next = static_cast<State>((t + 1) % stateCount);
+        for (auto& sm : machines) {
+            sm.update();
+            sm.transitionTo(next);
+        }
+    }
+    auto end = Clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(machineCount) * ticks);
+}
+
+int main() {
+    long long counter = 0;
+    double mapped = run(false, counter);
+    double dense = run(true, counter);
+    std::cout << machineCount << " machines, " << stateCount << " states, " << ticks << " ticks" << std::endl;
+    std::cout << "map lookup   " << mapped << " ns/tick" << std::endl;
+    std::cout << "compiled     " << dense << " ns/tick" << std::endl;
+    std::cout << "(checksum " << counter << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "worker_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+const int roots    = 1000;
+const int fanOut   = 100;
+const int workIters = 200;
+
+// Roughly a microsecond of work that the compiler cannot drop.
+void spin() {
+    volatile int sink = 0;
+    for (int i = 0; i < workIters; ++i) sink = sink + i;
+}
+
+double run(WorkerPool::Scheduling scheduling, std::size_t threads) {
+    std::atomic<int> done{0};
+    const int total = roots * (fanOut + 1);
+
+    WorkerPool pool(threads, scheduling);
+    auto start = Clock::now();
+    for (int r = 0; r < roots; ++r) {
+        pool.addJob([&pool, &done]() {
+            for (int c = 0; c < fanOut; ++c) {
+                pool.addJob([&done]() {
+                    spin();
+                    done.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+            done.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    while (done.load(std::memory_order_relaxed) < total) {
+        std::this_thread::yield();
+    }
+    auto end = Clock::now();
+
+    return total / std::chrono::duration<double>(end - start).count() / 1e6;
+}
+
+int main() {
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "fan-out jobs, " << roots << " roots x " << fanOut << " children, "
+              << threads << " workers" << std::endl;
+    std::cout << "SharedQueue   " << run(WorkerPool::Scheduling::SharedQueue, threads) << " Mjobs/s" << std::endl;
+    std::cout << "WorkStealing  " << run(WorkerPool::Scheduling::WorkStealing, threads) << " Mjobs/s" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,620 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <unistd.h>
+
+#include "thread_safe_iostream.hpp"
+
+// Deferred-format logging. A call site records its format id and the raw
+// binary arguments into a per-thread ring buffer; formatting happens later
+// on a background thread, which either hands text to LogWriter or writes
+// the binary records to a file for BinaryLog::decode to format offline.
+// The thread's threadSafeCout prefix (the name given to Thread) is kept.
+//
+//     THREAD_SAFE_LOG("request {} served in {} us", id, micros);
+//
+// Supported arguments: bool, char, integers, floating point, C strings,
+// std::string and std::string_view. Strings and the prefix are kept up to
+// 256 bytes; longer ones are cut and printed ending in "…[truncated]".
+// Without start() records are formatted on the spot and written through
+// LogWriter.
+#define THREAD_SAFE_LOG(format, ...) \
+    do { \
+        static BinaryLog::Site ftppLogSite_{format}; \
+        BinaryLog::instance().write(ftppLogSite_, threadSafeCout, ##__VA_ARGS__); \
+    } while (0)
+
+class BinaryLog {
+public:
+    enum class Output { Text, Binary };
+
+    struct Options {
+        Output                      output = Output::Text;
+        int                         fd = -1;                // Binary output destination, required
+        std::size_t                 ringBytes = 64 * 1024;  // per thread, rounded up to a power of two
+        std::chrono::milliseconds   pollInterval{1};
+    };
+
+    // One per call site; the id is assigned on first use.
+    struct Site {
+        const char*             format;
+        std::atomic<uint32_t>   id{0};
+    };
+
+    static BinaryLog& instance(void) {
+        static BinaryLog log;
+        return log;
+    }
+
+    ~BinaryLog(void) {
+        stop();
+    }
+
+    BinaryLog(const BinaryLog&) = delete;
+    BinaryLog& operator=(const BinaryLog&) = delete;
+
+    void start(void) {
+        start(Options());
+    }
+
+    void start(const Options& options) {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (running_.load(std::memory_order_acquire)) return;
+        if (options.output == Output::Binary && options.fd < 0) {
+            throw std::invalid_argument("binary log output needs a file descriptor");
+        }
+        options_ = options;
+        if (options_.output == Output::Binary) {
+            std::string magic(fileMagic, sizeof(fileMagic));
+            writeFd(magic);
+            emitted_.clear();
+        }
+        epoch_.fetch_add(1, std::memory_order_relaxed);
+        stopping_.store(false, std::memory_order_relaxed);
+        consumer_ = std::thread(&BinaryLog::consumerLoop, this);
+        running_.store(true, std::memory_order_release);
+    }
+
+    // Formats or writes everything recorded so far, then stops deferring.
+    // Records made while it runs are formatted on the spot once it returns.
+    void stop(void) {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (!running_.load(std::memory_order_acquire)) return;
+        draining_.store(true, std::memory_order_seq_cst);
+        running_.store(false, std::memory_order_seq_cst);
+        // A write() that saw running_ still set finishes its push first.
+        while (writers_.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+        stopping_.store(true, std::memory_order_release);
+        consumer_.join();
+        draining_.store(false, std::memory_order_release);
+    }
+
+    // Blocks until every record made before the call has been consumed.
+    void flush(void) {
+        if (running_.load(std::memory_order_acquire)) {
+            std::vector<std::pair<std::shared_ptr<Ring>, uint64_t>> marks;
+            {
+                std::lock_guard<std::mutex> lock(registryMutex_);
+                for (const auto& ring : rings_) {
+                    marks.emplace_back(ring, ring->head.load(std::memory_order_acquire));
+                }
+            }
+            for (const auto& [ring, mark] : marks) {
+                while (ring->tail.load(std::memory_order_acquire) < mark && running_.load(std::memory_order_acquire)) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+            }
+        }
+        LogWriter::instance().flush();
+    }
+
+    template<typename... TArgs>
+    void write(Site& site, const ThreadSafeIOStream& stream, const TArgs&... args) {
+        uint32_t id = site.id.load(std::memory_order_acquire);
+        if (id == 0) id = registerSite(site, signature<TArgs...>());
+
+        WriterScope scope(writers_);
+        if (!running_.load(std::memory_order_seq_cst)) {
+            scope.leave();
+            // Keeps the line behind the records a running stop() still drains.
+            if (draining_.load(std::memory_order_seq_cst)) {
+                std::lock_guard<std::mutex> lock(controlMutex_);
+            }
+            std::string line;
+            appendPrefix(line, stream.prefix());
+            char payload[maxRecord];
+            std::size_t size = encodeArgs(payload, args...);
+            formatInto(line, site.format, signature<TArgs...>(), payload, size);
+            line += '\n';
+            LogWriter::instance().write(std::move(line));
+            return;
+        }
+
+        // Announce the prefix on first use, when it changes and on restart.
+        ThreadState& state = threadState();
+        uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+        if (state.prefixVersion != stream.prefixVersion() || state.epoch != epoch || !state.ring) {
+            attach(state);
+            state.prefixVersion = stream.prefixVersion();
+            state.epoch = epoch;
+            char record[maxString + 8];
+            std::size_t size = 0;
+            record[size++] = 'P';
+            putText(record, size, stream.prefix());
+            state.ring->push(record, size);
+        }
+
+        char record[maxRecord];
+        std::size_t size = 0;
+        record[size++] = 'M';
+        put(record, size, id);
+        size += encodeArgs(record + size, args...);
+        state.ring->push(record, size);
+    }
+
+    // Formats a file produced with Output::Binary, one line per record.
+    // Returns false if the stream is not a binary log, or stops at the first
+    // record that is cut short or does not make sense (sizes over the
+    // writer's limits, unknown format, payload not matching its format).
+    static bool decode(std::istream& in, std::ostream& out) {
+        char magic[sizeof(fileMagic)];
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, fileMagic, sizeof(magic)) != 0) {
+            return false;
+        }
+
+        std::vector<std::pair<std::string, std::string>> formats;
+        std::vector<bool> defined;
+        std::vector<std::string> prefixes;
+        std::string line;
+        std::string payload;
+        char kind;
+        while (in.get(kind)) {
+            if (kind == 'F') {
+                uint32_t id;
+                std::pair<std::string, std::string> format;
+                if (!read(in, id) || id == 0 || id > maxDecodedIds
+                    || !readString(in, maxFormat, format.first) || !readString(in, maxRecord, format.second)) {
+                    return false;
+                }
+                if (formats.size() <= id) {
+                    formats.resize(id + 1);
+                    defined.resize(id + 1, false);
+                }
+                formats[id] = std::move(format);
+                defined[id] = true;
+            } else if (kind == 'P') {
+                uint32_t thread;
+                std::string prefix;
+                if (!read(in, thread) || thread >= maxDecodedIds
+                    || !readString(in, maxString + sizeof(truncatedMark), prefix)) {
+                    return false;
+                }
+                if (prefixes.size() <= thread) prefixes.resize(thread + 1);
+                prefixes[thread] = std::move(prefix);
+            } else if (kind == 'M') {
+                uint32_t thread;
+                uint32_t id;
+                if (!read(in, thread) || !read(in, id) || !readString(in, maxRecord, payload)
+                    || id >= formats.size() || !defined[id]) {
+                    return false;
+                }
+                line.clear();
+                if (thread < prefixes.size()) line += prefixes[thread];
+                if (!formatInto(line, formats[id].first.c_str(), formats[id].second, payload.data(), payload.size())) {
+                    return false;
+                }
+                out << line << '\n';
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr char        fileMagic[8] = {'F', 'T', 'P', 'P', 'L', 'O', 'G', '1'};
+    static constexpr std::size_t maxString = 256;
+    static constexpr uint16_t    truncatedFlag = 0x8000;     // in a string's length
+    static constexpr char        truncatedMark[] = "…[truncated]";
+    static constexpr std::size_t maxRecord = 4096;
+    static constexpr std::size_t maxFormat = 64 * 1024;       // decode() limits
+    static constexpr uint32_t    maxDecodedIds = 1u << 20;
+
+    // Single-producer single-consumer byte ring. Records are length-prefixed
+    // and may wrap around the end.
+    struct Ring {
+        std::vector<char>       data;
+        std::size_t             mask;
+        uint32_t                thread;
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint64_t> tail{0};
+        std::atomic<bool>       closed{false};
+
+        Ring(std::size_t bytes, uint32_t p_thread) : thread(p_thread) {
+            std::size_t capacity = 2 * maxRecord;
+            while (capacity < bytes) capacity <<= 1;
+            data.resize(capacity);
+            mask = capacity - 1;
+        }
+
+        // Waits for room rather than dropping records.
+        void push(const char* record, std::size_t size) {
+            uint16_t length = static_cast<uint16_t>(size);
+            uint64_t h = head.load(std::memory_order_relaxed);
+            while (data.size() - (h - tail.load(std::memory_order_acquire)) < size + sizeof(length)) {
+                std::this_thread::yield();
+            }
+            copyIn(h, reinterpret_cast<const char*>(&length), sizeof(length));
+            copyIn(h + sizeof(length), record, size);
+            head.store(h + sizeof(length) + size, std::memory_order_release);
+        }
+
+        void copyIn(uint64_t pos, const char* src, std::size_t size) {
+            std::size_t offset = static_cast<std::size_t>(pos) & mask;
+            std::size_t first = std::min(size, data.size() - offset);
+            std::memcpy(data.data() + offset, src, first);
+            std::memcpy(data.data(), src + first, size - first);
+        }
+
+        void copyOut(uint64_t pos, char* dst, std::size_t size) const {
+            std::size_t offset = static_cast<std::size_t>(pos) & mask;
+            std::size_t first = std::min(size, data.size() - offset);
+            std::memcpy(dst, data.data() + offset, first);
+            std::memcpy(dst + first, data.data(), size - first);
+        }
+    };
+
+    // Counts a write() in flight on the ring path, see stop().
+    struct WriterScope {
+        std::atomic<std::size_t>*   count;
+
+        explicit WriterScope(std::atomic<std::size_t>& p_count) : count(&p_count) {
+            count->fetch_add(1, std::memory_order_seq_cst);
+        }
+        ~WriterScope() { leave(); }
+
+        void leave(void) {
+            if (count) count->fetch_sub(1, std::memory_order_release);
+            count = nullptr;
+        }
+    };
+
+    struct ThreadState {
+        std::shared_ptr<Ring>   ring;
+        uint64_t                prefixVersion = ~uint64_t(0);
+        uint64_t                epoch = 0;
+
+        ~ThreadState() {
+            if (ring) ring->closed.store(true, std::memory_order_release);
+        }
+    };
+
+    BinaryLog(void) = default;
+
+    static ThreadState& threadState(void) {
+        thread_local ThreadState state;
+        return state;
+    }
+
+    void attach(ThreadState& state) {
+        if (state.ring) return;
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        state.ring = std::make_shared<Ring>(options_.ringBytes, nextThread_++);
+        rings_.push_back(state.ring);
+    }
+
+    uint32_t registerSite(Site& site, const std::string& sig) {
+        std::lock_guard<std::mutex> lock(formatMutex_);
+        uint32_t id = site.id.load(std::memory_order_acquire);
+        if (id != 0) return id;
+        formats_.emplace_back(site.format, sig);
+        id = static_cast<uint32_t>(formats_.size());
+        site.id.store(id, std::memory_order_release);
+        return id;
+    }
+
+    // ——— argument encoding ———
+
+    template<typename T>
+    static void put(char* out, std::size_t& size, T value) {
+        std::memcpy(out + size, &value, sizeof(value));
+        size += sizeof(value);
+    }
+
+    template<typename T>
+    static constexpr char typeCode(void) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, bool>) return 'b';
+        else if constexpr (std::is_same_v<U, char>) return 'c';
+        else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) return 'i';
+        else if constexpr (std::is_integral_v<U>) return 'u';
+        else if constexpr (std::is_floating_point_v<U>) return 'd';
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>) return 's';
+        else static_assert(!sizeof(T), "unsupported THREAD_SAFE_LOG argument type");
+    }
+
+    template<typename... TArgs>
+    static const std::string& signature(void) {
+        static const std::string sig = {typeCode<TArgs>()...};
+        return sig;
+    }
+
+    template<typename T>
+    static void encode(char* out, std::size_t& size, const T& value) {
+        constexpr char code = typeCode<T>();
+        if constexpr (code == 'b' || code == 'c') put(out, size, static_cast<char>(value));
+        else if constexpr (code == 'i') put(out, size, static_cast<int64_t>(value));
+        else if constexpr (code == 'u') put(out, size, static_cast<uint64_t>(value));
+        else if constexpr (code == 'd') put(out, size, static_cast<double>(value));
+        else putText(out, size, std::string_view(value));
+    }
+
+    // At most maxString bytes, truncatedFlag set in the length if cut.
+    static void putText(char* out, std::size_t& size, std::string_view text) {
+        uint16_t length = static_cast<uint16_t>(std::min(text.size(), maxString));
+        put(out, size, static_cast<uint16_t>(text.size() > maxString ? length | truncatedFlag : length));
+        std::memcpy(out + size, text.data(), length);
+        size += length;
+    }
+
+    static bool getText(std::string& out, const char* payload, std::size_t size, std::size_t& offset) {
+        uint16_t length;
+        if (!take(payload, size, offset, length)) return false;
+        uint16_t kept = length & ~truncatedFlag;
+        if (kept > size - offset) return false;
+        out.append(payload + offset, kept);
+        offset += kept;
+        if (length & truncatedFlag) out += truncatedMark;
+        return true;
+    }
+
+    static void appendPrefix(std::string& out, std::string_view prefix) {
+        out.append(prefix.data(), std::min(prefix.size(), maxString));
+        if (prefix.size() > maxString) out += truncatedMark;
+    }
+
+    template<typename... TArgs>
+    static std::size_t encodeArgs(char* out, const TArgs&... args) {
+        static_assert(sizeof...(TArgs) <= (maxRecord - 8) / (maxString + 2), "too many THREAD_SAFE_LOG arguments");
+        std::size_t size = 0;
+        (encode(out, size, args), ...);
+        return size;
+    }
+
+    // ——— formatting ———
+
+    template<typename T>
+    static T get(const char* payload, std::size_t& offset) {
+        T value;
+        std::memcpy(&value, payload + offset, sizeof(value));
+        offset += sizeof(value);
+        return value;
+    }
+
+    // Bounds-checked get(), payloads read back from a file are not trusted.
+    template<typename T>
+    static bool take(const char* payload, std::size_t size, std::size_t& offset, T& value) {
+        if (sizeof(T) > size - offset) return false;
+        value = get<T>(payload, offset);
+        return true;
+    }
+
+    // Replaces each "{}" of format with the next argument. Returns false if
+    // the payload does not hold the arguments sig describes.
+    static bool formatInto(std::string& out, const char* format, const std::string& sig,
+                           const char* payload, std::size_t size) {
+        std::size_t offset = 0;
+        std::size_t arg = 0;
+        char number[32];
+        char c;
+        int64_t i;
+        uint64_t u;
+        double d;
+        for (const char* p = format; *p; ++p) {
+            if (p[0] != '{' || p[1] != '}' || arg >= sig.size()) {
+                out += *p;
+                continue;
+            }
+            ++p;
+            switch (sig[arg++]) {
+                case 'b':
+                    if (!take(payload, size, offset, c)) return false;
+                    out += c ? "true" : "false";
+                    break;
+                case 'c':
+                    if (!take(payload, size, offset, c)) return false;
+                    out += c;
+                    break;
+                case 'i':
+                    if (!take(payload, size, offset, i)) return false;
+                    out += std::to_string(i);
+                    break;
+                case 'u':
+                    if (!take(payload, size, offset, u)) return false;
+                    out += std::to_string(u);
+                    break;
+                case 'd':
+                    if (!take(payload, size, offset, d)) return false;
+                    std::snprintf(number, sizeof(number), "%g", d);
+                    out += number;
+                    break;
+                case 's':
+                    if (!getText(out, payload, size, offset)) return false;
+                    break;
+                default:
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // ——— consumer ———
+
+    void consumerLoop(void) {
+        std::vector<char> record(maxRecord);
+        std::vector<std::shared_ptr<Ring>> rings;
+        std::vector<uint64_t> tails;
+        std::string batch;
+        while (true) {
+            bool last = stopping_.load(std::memory_order_acquire);
+            {
+                std::lock_guard<std::mutex> lock(registryMutex_);
+                rings = rings_;
+            }
+
+            bool progress = false;
+            tails.clear();
+            for (const auto& ring : rings) {
+                uint64_t t = ring->tail.load(std::memory_order_relaxed);
+                uint64_t h = ring->head.load(std::memory_order_acquire);
+                while (t < h) {
+                    uint16_t length;
+                    ring->copyOut(t, reinterpret_cast<char*>(&length), sizeof(length));
+                    ring->copyOut(t + sizeof(length), record.data(), length);
+                    t += sizeof(length) + length;
+                    consume(*ring, record.data(), length, batch);
+                    progress = true;
+                }
+                tails.push_back(t);
+            }
+            if (!batch.empty()) {
+                if (options_.output == Output::Text) LogWriter::instance().write(std::move(batch));
+                else writeFd(batch);
+                batch.clear();
+            }
+            // Released only once the records were handed on, so flush()
+            // can wait on the tails.
+            for (std::size_t i = 0; i < rings.size(); ++i) {
+                rings[i]->tail.store(tails[i], std::memory_order_release);
+            }
+            dropClosed();
+
+            if (last) return;
+            if (!progress) std::this_thread::sleep_for(options_.pollInterval);
+        }
+    }
+
+    void consume(const Ring& ring, const char* record, std::size_t size, std::string& batch) {
+        std::size_t offset = 1;
+        if (record[0] == 'P') {
+            std::string prefix;
+            getText(prefix, record, size, offset);
+            if (options_.output == Output::Binary) {
+                batch += 'P';
+                append(batch, ring.thread);
+                appendString(batch, prefix);
+            } else {
+                if (prefixes_.size() <= ring.thread) prefixes_.resize(ring.thread + 1);
+                prefixes_[ring.thread] = prefix;
+            }
+            return;
+        }
+
+        uint32_t id = get<uint32_t>(record, offset);
+        if (knownFormats_.size() < id) {
+            std::lock_guard<std::mutex> lock(formatMutex_);
+            knownFormats_ = formats_;
+        }
+        const std::pair<std::string, std::string>& format = knownFormats_[id - 1];
+        if (options_.output == Output::Binary) {
+            if (emitted_.size() <= id) emitted_.resize(id + 1, false);
+            if (!emitted_[id]) {
+                emitted_[id] = true;
+                batch += 'F';
+                append(batch, id);
+                appendString(batch, format.first);
+                appendString(batch, format.second);
+            }
+            batch += 'M';
+            append(batch, ring.thread);
+            append(batch, id);
+            appendString(batch, std::string(record + offset, size - offset));
+            return;
+        }
+        if (ring.thread < prefixes_.size()) batch += prefixes_[ring.thread];
+        formatInto(batch, format.first.c_str(), format.second, record + offset, size - offset);
+        batch += '\n';
+    }
+
+    void dropClosed(void) {
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<Ring>& ring) {
+            return ring->closed.load(std::memory_order_acquire)
+                && ring->tail.load(std::memory_order_relaxed) == ring->head.load(std::memory_order_acquire);
+        }), rings_.end());
+    }
+
+    template<typename T>
+    static void append(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    static void appendString(std::string& out, const std::string& text) {
+        append(out, static_cast<uint32_t>(text.size()));
+        out += text;
+    }
+
+    template<typename T>
+    static bool read(std::istream& in, T& value) {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+    }
+
+    // Fails on a cut record or a length above limit.
+    static bool readString(std::istream& in, std::size_t limit, std::string& text) {
+        uint32_t length;
+        if (!read(in, length) || length > limit) return false;
+        text.resize(length);
+        return static_cast<bool>(in.read(text.data(), static_cast<std::streamsize>(length)));
+    }
+
+    void writeFd(const std::string& bytes) {
+        std::size_t offset = 0;
+        while (offset < bytes.size()) {
+            ssize_t n = ::write(options_.fd, bytes.data() + offset, bytes.size() - offset);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            offset += static_cast<std::size_t>(n);
+        }
+    }
+
+    std::mutex                          controlMutex_;
+    std::atomic<bool>                   running_{false};
+    std::atomic<bool>                   stopping_{false};
+    std::atomic<bool>                   draining_{false};   // stop() in progress
+    std::atomic<std::size_t>            writers_{0};        // write() calls on the ring path
+    std::atomic<uint64_t>               epoch_{0};
+    Options                             options_;
+    std::thread                         consumer_;
+
+    std::mutex                          registryMutex_;
+    std::vector<std::shared_ptr<Ring>>  rings_;
+    uint32_t                            nextThread_ = 0;
+
+    std::mutex                          formatMutex_;
+    std::vector<std::pair<std::string, std::string>> formats_;
+
+    // Consumer-only state.
+    std::vector<std::string>            prefixes_;
+    std::vector<bool>                   emitted_;
+    std::vector<std::pair<std::string, std::string>> knownFormats_;
+};
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cerrno>
 #include <cstddef>
+#include <cstring>
 #include <stdexcept>
 #include <string>
 #include <functional>
@@ -65,12 +67,10 @@ public:
     void send(const Message& message) {
         std::lock_guard<std::mutex> lock(mutex);
 
-        std::vector<uint8_t> frame = message.raw();
-        const uint8_t* ptr = frame.data();
-        std::size_t   left = frame.size();
+        Message::Frame frame = message.frame();
 
-        while (left > 0) {
-            ssize_t sent = ::send(sockfd, ptr, left, 0);
+        while (!frame.done()) {
+            ssize_t sent = frame.writeTo(sockfd);
             if (sent < 0) {
                 if (errno == EINTR) {
                     continue;
@@ -80,8 +80,6 @@ public:
                 }
                 throw std::runtime_error(std::string{"Client::send() failed: "} + std::strerror(errno));
             }
-            ptr  += sent;
-            left -= sent;
         }
     }
 
@@ -114,12 +112,7 @@ public:
 
             if (rawBuf.size() - offset < 8 + payloadSz) break;
 
-            std::vector<uint8_t> frame(
-                rawBuf.begin() + offset,
-                rawBuf.begin() + offset + 8 + payloadSz
-            );
-
-            Message msg = Message::fromRaw(frame);
+            Message msg = Message::fromRaw(rawBuf.data() + offset, 8 + payloadSz);
             handlers[netType](msg);
 
             offset += 8 + payloadSz;
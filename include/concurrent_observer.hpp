@@ -0,0 +1,299 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mpsc_queue.hpp"
+#include "observer.hpp"
+
+// Thread-safe counterpart of Observer. notify() may be called from any
+// thread without taking a lock: it reads an immutable subscriber table that
+// subscribe()/unsubscribe() replace copy-on-write under a writer mutex.
+// Readers announce themselves on one of two counters picked by the current
+// epoch. A replaced table is retired; a later write flips the epoch once
+// the previous grace period is over, and frees what was retired before the
+// flip when the old epoch's counter drains. Writers never wait for readers,
+// so callbacks may subscribe or unsubscribe. As with RCU, a callback can
+// still run once on another thread after unsubscribe() returns.
+//
+// post() queues an event instead of running the callbacks on the caller.
+// flush() delivers everything queued so far on the calling thread, in
+// posting order per thread; with coalescing on, repeated events in one batch
+// are delivered once with the latest payload. Options::onPending is called
+// by the first post() after a flush, e.g. to have a Server loop flush:
+//   options.onPending = [&]() { server.post([&]() { bus.flush(); }); };
+template<typename TEvent, typename TPayload = void>
+class ConcurrentObserver {
+public:
+    using Callback = typename ObserverCallback<TPayload>::type;
+    using SubscriptionId = uint64_t;
+
+    static constexpr SubscriptionId invalidSubscription = 0;
+
+    struct Options {
+        bool                    coalesce = true;
+        std::function<void()>   onPending;
+    };
+
+    ConcurrentObserver(void) : ConcurrentObserver(Options()) {}
+
+    explicit ConcurrentObserver(const Options& options)
+        : options_(options), table_(new Table()) {}
+
+    ConcurrentObserver(const ConcurrentObserver&) = delete;
+    ConcurrentObserver& operator=(const ConcurrentObserver&) = delete;
+
+    ~ConcurrentObserver(void) {
+        delete table_.load(std::memory_order_relaxed);
+        for (const Table* table : draining_) delete table;
+        for (const Table* table : waiting_) delete table;
+    }
+
+    SubscriptionId subscribe(const TEvent& event, Callback callback) {
+        auto shared = std::make_shared<const Callback>(std::move(callback));
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        SubscriptionId id = ++lastId_;
+        auto next = std::make_unique<Table>(*table_.load(std::memory_order_relaxed));
+        next->channels[next->channelFor(event)].push_back({id, std::move(shared)});
+        publish(std::move(next));
+        return id;
+    }
+
+    // Returns false if the id is unknown or already unsubscribed.
+    bool unsubscribe(SubscriptionId id) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        const Table* table = table_.load(std::memory_order_relaxed);
+        for (std::size_t c = 0; c < table->channels.size(); ++c) {
+            const std::vector<Entry>& entries = table->channels[c];
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                if (entries[i].id != id) continue;
+                auto next = std::make_unique<Table>(*table);
+                next->channels[c].erase(next->channels[c].begin() + i);
+                publish(std::move(next));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void notify(const TEvent& event) {
+        static_assert(std::is_void_v<TPayload>, "this ConcurrentObserver needs a payload");
+        ReadGuard guard(*this);
+        deliver(guard.table(), guard.table().findChannel(event));
+    }
+
+    template<typename P = TPayload>
+    void notify(const TEvent& event, const std::enable_if_t<!std::is_void_v<P>, P>& payload) {
+        ReadGuard guard(*this);
+        deliver(guard.table(), guard.table().findChannel(event), payload);
+    }
+
+    void post(const TEvent& event) {
+        static_assert(std::is_void_v<TPayload>, "this ConcurrentObserver needs a payload");
+        enqueue(Posted{event, Stored()});
+    }
+
+    template<typename P = TPayload>
+    void post(const TEvent& event, const std::enable_if_t<!std::is_void_v<P>, P>& payload) {
+        enqueue(Posted{event, payload});
+    }
+
+    // Delivers the queued events on the calling thread and returns how many
+    // reached at least one subscriber.
+    std::size_t flush(void) {
+        std::lock_guard<std::mutex> lock(flushMutex_);
+        pendingSignalled_.exchange(false, std::memory_order_acq_rel);
+
+        ReadGuard guard(*this);
+        const Table& table = guard.table();
+        batch_.clear();
+        if (slotOf_.size() < table.channels.size()) slotOf_.resize(table.channels.size(), npos);
+        while (auto posted = queue_.try_pop()) {
+            std::size_t channel = table.findChannel(posted->event);
+            if (channel == npos || table.channels[channel].empty()) continue;
+            if (options_.coalesce && slotOf_[channel] != npos) {
+                batch_[slotOf_[channel]].second = std::move(posted->payload);
+                continue;
+            }
+            slotOf_[channel] = batch_.size();
+            batch_.emplace_back(channel, std::move(posted->payload));
+        }
+
+        // Reset before delivering so a throwing callback leaves no stale
+        // slots behind for the next flush().
+        for (const auto& slot : batch_) slotOf_[slot.first] = npos;
+        for (auto& [channel, payload] : batch_) {
+            if constexpr (std::is_void_v<TPayload>) {
+                (void)payload;
+                deliver(table, channel);
+            } else {
+                deliver(table, channel, payload);
+            }
+        }
+        std::size_t delivered = batch_.size();
+        batch_.clear();
+        return delivered;
+    }
+
+    std::size_t subscriberCount(const TEvent& event) const {
+        ReadGuard guard(*this);
+        std::size_t channel = guard.table().findChannel(event);
+        return channel == npos ? 0 : guard.table().channels[channel].size();
+    }
+
+private:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+    static constexpr long long maxDenseEvent = 1 << 16;
+
+    struct Entry {
+        SubscriptionId                  id;
+        std::shared_ptr<const Callback> callback;
+    };
+
+    // Immutable once published.
+    struct Table {
+        std::vector<std::vector<Entry>> channels;
+        std::vector<std::size_t>        denseIndex;   // event value -> channel + 1
+        std::map<TEvent, std::size_t>   sparseIndex;  // events outside the dense range
+
+        static bool isDense(const TEvent& event, long long& value) {
+            if constexpr (std::is_enum_v<TEvent> || std::is_integral_v<TEvent>) {
+                value = static_cast<long long>(event);
+                return value >= 0 && value < maxDenseEvent;
+            } else {
+                (void)event;
+                (void)value;
+                return false;
+            }
+        }
+
+        std::size_t findChannel(const TEvent& event) const {
+            long long value;
+            if (isDense(event, value)) {
+                std::size_t slot = static_cast<std::size_t>(value);
+                return slot < denseIndex.size() ? denseIndex[slot] - 1 : npos;
+            }
+            auto it = sparseIndex.find(event);
+            return it == sparseIndex.end() ? npos : it->second - 1;
+        }
+
+        std::size_t channelFor(const TEvent& event) {
+            std::size_t channel = findChannel(event);
+            if (channel != npos) return channel;
+            channel = channels.size();
+            channels.emplace_back();
+            long long value;
+            if (isDense(event, value)) {
+                std::size_t slot = static_cast<std::size_t>(value);
+                if (slot >= denseIndex.size()) denseIndex.resize(slot + 1, 0);
+                denseIndex[slot] = channel + 1;
+            } else {
+                sparseIndex[event] = channel + 1;
+            }
+            return channel;
+        }
+    };
+
+    struct Empty {};
+    using Stored = std::conditional_t<std::is_void_v<TPayload>, Empty, TPayload>;
+
+    struct Posted {
+        TEvent event;
+        Stored payload;
+    };
+
+    // Registers a reader on the counter of the current epoch for as long as
+    // it lives. The epoch is re-read after counting so a reader never sits
+    // on a counter a writer has already stopped watching.
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const ConcurrentObserver& owner) : owner_(owner) {
+            for (;;) {
+                epoch_ = owner_.epoch_.load();
+                owner_.readers_[epoch_ & 1].count.fetch_add(1);
+                if (owner_.epoch_.load() == epoch_) break;
+                owner_.readers_[epoch_ & 1].count.fetch_sub(1);
+            }
+            table_ = owner_.table_.load();
+        }
+
+        ~ReadGuard(void) { owner_.readers_[epoch_ & 1].count.fetch_sub(1, std::memory_order_release); }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        const Table& table(void) const { return *table_; }
+
+    private:
+        const ConcurrentObserver&   owner_;
+        uint64_t                    epoch_;
+        const Table*                table_;
+    };
+
+    struct alignas(64) ReaderCount {
+        std::atomic<std::size_t> count{0};
+    };
+
+    Options                         options_;
+    std::atomic<const Table*>       table_;
+    std::atomic<uint64_t>           epoch_{0};
+    mutable ReaderCount             readers_[2];    // indexed by epoch parity
+
+    std::mutex                      writeMutex_;    // guards the fields below
+    SubscriptionId                  lastId_ = invalidSubscription;
+    std::vector<const Table*>       waiting_;       // retired in the current epoch
+    std::vector<const Table*>       draining_;      // retired before the last flip
+
+    MpscQueue<Posted>               queue_;
+    std::atomic<bool>               pendingSignalled_{false};
+    std::mutex                      flushMutex_;
+    std::vector<std::pair<std::size_t, Stored>> batch_;
+    std::vector<std::size_t>        slotOf_;        // channel -> position in batch_
+
+    template<typename... TArgs>
+    static void deliver(const Table& table, std::size_t channel, const TArgs&... payload) {
+        if (channel == npos) return;
+        for (const Entry& entry : table.channels[channel]) {
+            (*entry.callback)(payload...);
+        }
+    }
+
+    void enqueue(Posted posted) {
+        queue_.push(std::move(posted));
+        if (!pendingSignalled_.exchange(true, std::memory_order_acq_rel) && options_.onPending) {
+            options_.onPending();
+        }
+    }
+
+    // Called with writeMutex_ held.
+    void publish(std::unique_ptr<Table> next) {
+        waiting_.push_back(table_.load(std::memory_order_relaxed));
+        table_.store(next.release());
+        reclaim();
+    }
+
+    // Frees draining_ once no reader is left on the previous epoch, then
+    // starts a new grace period for waiting_. Called with writeMutex_ held.
+    void reclaim(void) {
+        for (;;) {
+            if (!draining_.empty()) {
+                uint64_t previous = epoch_.load() - 1;
+                if (readers_[previous & 1].count.load() != 0) return;
+                for (const Table* table : draining_) delete table;
+                draining_.clear();
+            }
+            if (waiting_.empty()) return;
+            draining_.swap(waiting_);
+            epoch_.fetch_add(1);
+        }
+    }
+};
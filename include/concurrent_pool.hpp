@@ -0,0 +1,295 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Gives every live thread a small dense index, recycled when the thread exits.
+class ThreadIndex {
+public:
+    static std::size_t get() {
+        thread_local Holder holder;
+        return holder.index;
+    }
+
+private:
+    struct Registry {
+        std::mutex               mutex;
+        std::vector<std::size_t> freed;
+        std::size_t              next = 0;
+    };
+
+    static Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    struct Holder {
+        std::size_t index;
+
+        Holder() {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            if (r.freed.empty()) {
+                index = r.next++;
+            } else {
+                index = r.freed.back();
+                r.freed.pop_back();
+            }
+        }
+
+        ~Holder() {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.freed.push_back(index);
+        }
+    };
+};
+
+// Pool usable from several threads at once. Each thread keeps two magazines
+// of free slots, so acquire and release normally touch only thread-local
+// data. Full and empty magazines are exchanged with a shared depot under a
+// mutex, and new chunks are added there when the depot runs dry. An object
+// may be released on another thread than the one that acquired it.
+// Threads beyond maxThreads skip the caches and always go through the depot.
+template<typename TType>
+class ConcurrentPool {
+public:
+    static constexpr std::size_t magazineSize = 64;
+    static constexpr std::size_t slotSize  = std::max(sizeof(TType), sizeof(void*));
+    static constexpr std::size_t slotAlign = std::max(alignof(TType), alignof(void*));
+
+    class Object;
+
+    explicit ConcurrentPool(std::size_t chunkSize = 1024, std::size_t maxThreads = 64)
+        : chunkSize_(std::max(chunkSize, magazineSize)), caches_(maxThreads) {}
+
+    ~ConcurrentPool() noexcept {
+        std::vector<void*> freeSlots;
+        auto collect = [&freeSlots](const Magazine* m) {
+            if (m) freeSlots.insert(freeSlots.end(), m->slots, m->slots + m->count);
+        };
+        for (Cache& c : caches_) {
+            collect(c.loaded);
+            collect(c.previous);
+        }
+        for (Magazine* m : full_) collect(m);
+        std::sort(freeSlots.begin(), freeSlots.end());
+
+        for (char* chunk : chunks_) {
+            for (std::size_t i = 0; i < chunkSize_; ++i) {
+                void* slot = chunk + i * slotSize;
+                if (!std::binary_search(freeSlots.begin(), freeSlots.end(), slot)) {
+                    static_cast<TType*>(slot)->~TType();
+                }
+            }
+            operator delete[](chunk, std::align_val_t(slotAlign));
+        }
+        for (Cache& c : caches_) {
+            delete c.loaded;
+            delete c.previous;
+        }
+        for (Magazine* m : full_)  delete m;
+        for (Magazine* m : empty_) delete m;
+    }
+
+    ConcurrentPool(const ConcurrentPool&) = delete;
+    ConcurrentPool& operator=(const ConcurrentPool&) = delete;
+
+    template<typename... TArgs>
+    Object acquire(TArgs&&... args) {
+        return Object(this, construct(std::forward<TArgs>(args)...));
+    }
+
+    // Raw counterpart of acquire() for owners that keep plain pointers,
+    // the object must be handed back with destroy().
+    template<typename... TArgs>
+    TType* construct(TArgs&&... args) {
+        void* slot = pop();
+        try {
+            return new (slot) TType(std::forward<TArgs>(args)...);
+        } catch (...) {
+            push(slot);
+            throw;
+        }
+    }
+
+    void destroy(TType* ptr) noexcept {
+        release(ptr);
+    }
+
+private:
+    struct Magazine {
+        std::size_t count = 0;
+        void*       slots[magazineSize];
+    };
+
+    struct alignas(64) Cache {
+        Magazine* loaded   = nullptr;
+        Magazine* previous = nullptr;
+    };
+
+    Cache* localCache() {
+        std::size_t index = ThreadIndex::get();
+        return index < caches_.size() ? &caches_[index] : nullptr;
+    }
+
+    void* pop() {
+        Cache* cache = localCache();
+        if (cache == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Magazine* m = takeFull();
+            void* slot = m->slots[--m->count];
+            (m->count ? full_ : empty_).push_back(m);
+            return slot;
+        }
+
+        if (cache->loaded && cache->loaded->count > 0) {
+            return cache->loaded->slots[--cache->loaded->count];
+        }
+        if (cache->previous && cache->previous->count > 0) {
+            std::swap(cache->loaded, cache->previous);
+            return cache->loaded->slots[--cache->loaded->count];
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Magazine* fresh = takeFull();
+            if (cache->previous) empty_.push_back(cache->previous);
+            cache->previous = cache->loaded;
+            cache->loaded = fresh;
+        }
+        return cache->loaded->slots[--cache->loaded->count];
+    }
+
+    void push(void* slot) noexcept {
+        Cache* cache = localCache();
+        if (cache == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pushLocked(slot);
+            return;
+        }
+
+        if (cache->loaded && cache->loaded->count < magazineSize) {
+            cache->loaded->slots[cache->loaded->count++] = slot;
+            return;
+        }
+        if (cache->previous && cache->previous->count < magazineSize) {
+            std::swap(cache->loaded, cache->previous);
+            cache->loaded->slots[cache->loaded->count++] = slot;
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        Magazine* fresh = takeEmpty();
+        if (fresh == nullptr) {
+            pushLocked(slot);
+            return;
+        }
+        if (cache->previous) full_.push_back(cache->previous);
+        cache->previous = cache->loaded;
+        cache->loaded = fresh;
+        cache->loaded->slots[cache->loaded->count++] = slot;
+    }
+
+    void release(TType* ptr) noexcept {
+        ptr->~TType();
+        push(ptr);
+    }
+
+    // Depot helpers, called with mutex_ held.
+    Magazine* takeFull() {
+        if (full_.empty()) grow();
+        Magazine* m = full_.back();
+        full_.pop_back();
+        return m;
+    }
+
+    Magazine* takeEmpty() noexcept {
+        if (!empty_.empty()) {
+            Magazine* m = empty_.back();
+            empty_.pop_back();
+            return m;
+        }
+        return new (std::nothrow) Magazine();
+    }
+
+    void pushLocked(void* slot) noexcept {
+        if (!full_.empty() && full_.back()->count < magazineSize) {
+            full_.back()->slots[full_.back()->count++] = slot;
+            return;
+        }
+        Magazine* m = takeEmpty();
+        if (m == nullptr) std::terminate();
+        m->slots[m->count++] = slot;
+        full_.push_back(m);
+    }
+
+    void grow() {
+        std::size_t needed = (chunkSize_ + magazineSize - 1) / magazineSize;
+        std::vector<Magazine*> magazines;
+        char* chunk = nullptr;
+        try {
+            magazines.reserve(needed);
+            full_.reserve(full_.size() + needed);
+            chunks_.reserve(chunks_.size() + 1);
+            while (magazines.size() < needed) {
+                Magazine* m = takeEmpty();
+                if (m == nullptr) throw std::bad_alloc();
+                magazines.push_back(m);
+            }
+            chunk = static_cast<char*>(operator new[](chunkSize_ * slotSize, std::align_val_t(slotAlign)));
+        } catch (...) {
+            for (Magazine* m : magazines) delete m;
+            throw;
+        }
+
+        chunks_.push_back(chunk);
+        std::size_t i = 0;
+        for (Magazine* m : magazines) {
+            for (; i < chunkSize_ && m->count < magazineSize; ++i) {
+                m->slots[m->count++] = chunk + i * slotSize;
+            }
+            full_.push_back(m);
+        }
+    }
+
+    std::size_t             chunkSize_;
+    std::vector<Cache>      caches_;
+    std::mutex              mutex_;
+    std::vector<char*>      chunks_;
+    std::vector<Magazine*>  full_;
+    std::vector<Magazine*>  empty_;
+};
+
+template<typename TType>
+class ConcurrentPool<TType>::Object {
+public:
+    Object(Object&& other) noexcept
+        : pool(other.pool), ptr(other.ptr), released(other.released) {
+        other.released = true;
+    }
+
+    ~Object() noexcept {
+        if (!released) {
+            pool->release(ptr);
+            released = true;
+        }
+    }
+
+    TType* operator->() { return ptr; }
+    TType& operator*() { return *ptr; }
+
+private:
+    friend ConcurrentPool;
+    Object(ConcurrentPool* p, TType* pPtr) noexcept
+        : pool(p), ptr(pPtr), released(false) {}
+
+    ConcurrentPool* pool;
+    TType*          ptr;
+    bool            released;
+};
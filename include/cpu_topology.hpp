@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// CPU and NUMA layout as seen by this process, read from the scheduler and
+// sysfs. Outside Linux nothing is known and pinning/naming are no-ops.
+class CpuTopology {
+public:
+    // CPUs the process is allowed to run on.
+    static std::vector<int> allowedCpus(void) {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+            }
+        }
+#endif
+        return cpus;
+    }
+
+    // Allowed CPUs grouped by NUMA node. A single group when the machine
+    // has one node or the layout cannot be read.
+    static std::vector<std::vector<int>> numaNodes(void) {
+        std::vector<int> allowed = allowedCpus();
+        std::vector<std::vector<int>> nodes;
+        for (int node : parseCpuList(readFile("/sys/devices/system/node/online"))) {
+            std::vector<int> cpus;
+            for (int cpu : parseCpuList(readFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))) {
+                if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) cpus.push_back(cpu);
+            }
+            if (!cpus.empty()) nodes.push_back(cpus);
+        }
+        if (nodes.empty()) nodes.push_back(allowed);
+        return nodes;
+    }
+
+    // Restricts the calling thread to cpus. Returns false if it could not.
+    static bool pinCurrentThread(const std::vector<int>& cpus) {
+#ifdef __linux__
+        if (cpus.empty()) return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpus;
+        return false;
+#endif
+    }
+
+    // Shown by top, ps and perf. Linux keeps at most 15 characters.
+    static void nameCurrentThread(const std::string& name) {
+#ifdef __linux__
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#else
+        (void)name;
+#endif
+    }
+
+    // Parses the kernel list format, e.g. "0-3,8,10-11".
+    static std::vector<int> parseCpuList(const std::string& list) {
+        std::vector<int> result;
+        std::stringstream ss(list);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (item.empty() || item == "\n") continue;
+            std::size_t dash = item.find('-');
+            int first = std::atoi(item.c_str());
+            int last = dash == std::string::npos ? first : std::atoi(item.c_str() + dash + 1);
+            for (int i = first; i <= last; ++i) result.push_back(i);
+        }
+        return result;
+    }
+
+private:
+    static std::string readFile(const std::string& path) {
+        std::ifstream in(path);
+        std::string content;
+        std::getline(in, content);
+        return content;
+    }
+};
@@ -1,66 +1,194 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <vector>
 #include <cstdint>
 #include <stdexcept>
 #include <cstring>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
+// Structs are copied byte for byte only when they opt in, e.g.
+//   template<> struct DataBufferBinary<Color> : std::true_type {};
+// Only do so for types without pointers or references to other memory.
+template<typename T>
+struct DataBufferBinary : std::false_type {};
+
+// Arithmetic and enum values are stored fixed-width in little-endian order,
+// define FTPP_DATABUFFER_BIG_ENDIAN to put them on the wire in network order.
+// wrap() turns the buffer into a read-only view of memory owned elsewhere,
+// e.g. a memory-mapped file; writing to a view throws std::logic_error.
 class DataBuffer {
+public:
+    enum class Endian { Little, Big };
+
+#ifdef FTPP_DATABUFFER_BIG_ENDIAN
+    static constexpr Endian wireOrder = Endian::Big;
+#else
+    static constexpr Endian wireOrder = Endian::Little;
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    static constexpr Endian hostOrder = Endian::Big;
+#else
+    static constexpr Endian hostOrder = Endian::Little;
+#endif
+
+    // Scalars get a byte-order fixup, opted-in types are copied as they sit
+    // in memory. Everything else goes through the stream path.
+    template<typename T>
+    static constexpr bool isScalar = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+    template<typename T>
+    static constexpr bool isBinary = isScalar<T> || DataBufferBinary<T>::value;
+
+    // std::string, std::string_view and the like are written as their text.
+    template<typename T>
+    static constexpr bool isStringLike = std::is_convertible_v<const T&, std::string_view>;
+
+    template<typename T>
+    static constexpr bool isCString = std::is_same_v<std::decay_t<T>, char*>
+        || std::is_same_v<std::decay_t<T>, const char*>;
+
 private:
     std::vector<uint8_t> buffer;
     mutable std::size_t pos = 0;
+    const uint8_t* view = nullptr;
+    std::size_t viewSize = 0;
+
+    void ensureWritable(void) const {
+        if (view)
+            throw std::logic_error("DataBuffer is a read-only view.");
+    }
 
     void append(const void* src, std::size_t size) {
+        ensureWritable();
         const uint8_t* ptr = reinterpret_cast<const uint8_t*>(src);
         buffer.insert(buffer.end(), ptr, ptr + size);
     }
 
     void read(void* dst, std::size_t size) const {
-        if (pos + size > buffer.size())
+        if (pos + size > this->size())
             throw std::out_of_range("Out of range.");
-        std::memcpy(dst, buffer.data() + pos, size);
+        std::memcpy(dst, bytes() + pos, size);
         pos += size;
     }
 
+    template<typename T>
+    void writeBinary(const T& obj) {
+        static_assert(std::is_trivially_copyable_v<T>, "DataBufferBinary types must be trivially copyable");
+        uint8_t bytes[sizeof(T)];
+        std::memcpy(bytes, &obj, sizeof(T));
+        if constexpr (isScalar<T> && sizeof(T) > 1 && wireOrder != hostOrder) {
+            std::reverse(bytes, bytes + sizeof(T));
+        }
+        append(bytes, sizeof(T));
+    }
+
+    template<typename T>
+    void readBinary(T& obj) const {
+        uint8_t bytes[sizeof(T)];
+        read(bytes, sizeof(T));
+        if constexpr (std::is_same_v<T, bool>) {
+            // Copying any byte but 0 or 1 into a bool is undefined.
+            obj = bytes[0] != 0;
+        } else {
+            if constexpr (isScalar<T> && sizeof(T) > 1 && wireOrder != hostOrder) {
+                std::reverse(bytes, bytes + sizeof(T));
+            }
+            std::memcpy(&obj, bytes, sizeof(T));
+        }
+    }
+
+    void writeString(const char* str, std::size_t len) {
+        writeBinary(static_cast<uint64_t>(len));
+        append(str, len);
+    }
+
 public:
     DataBuffer() = default;
 
-   template<typename T>
+    template<typename T>
     DataBuffer& operator<<(const T& obj) {
-        std::ostringstream oss;
-        oss << obj;
-        std::string s = oss.str();
-
-        uint64_t len = s.size();
-        append(&len, sizeof(len));
-        append(s.data(), s.size());
-    
+        if constexpr (isCString<T>) {
+            writeString(obj, std::strlen(obj));
+        } else if constexpr (isStringLike<T>) {
+            std::string_view text = obj;
+            writeString(text.data(), text.size());
+        } else if constexpr (isBinary<T>) {
+            writeBinary(obj);
+        } else {
+            std::ostringstream oss;
+            oss << obj;
+            std::string s = oss.str();
+            writeString(s.data(), s.size());
+        }
         return *this;
     }
 
     template<typename T>
     DataBuffer& operator>>(T& obj) const {
-        uint64_t len;
-        read(&len, sizeof(len));
-
-        std::string s;
-        s.resize(len);
-        read(&s[0], len);
-
-        std::istringstream iss(s);
-        iss >> obj;
-        
+        if constexpr (std::is_same_v<T, std::string>) {
+            uint64_t len;
+            readBinary(len);
+            if (len > size() - pos)
+                throw std::out_of_range("Out of range.");
+            obj.assign(reinterpret_cast<const char*>(bytes() + pos), len);
+            pos += len;
+        } else if constexpr (isBinary<T>) {
+            readBinary(obj);
+        } else {
+            std::string s;
+            *this >> s;
+            std::istringstream iss(s);
+            iss >> obj;
+        }
         return const_cast<DataBuffer&>(*this);
     }
 
-    std::size_t size(void) const { return buffer.size(); }
-    const std::vector<uint8_t>& data(void) const { return buffer; }
+    std::size_t size(void) const { return view ? viewSize : buffer.size(); }
+    const uint8_t* bytes(void) const { return view ? view : buffer.data(); }
+    bool isView(void) const { return view != nullptr; }
     void resetReadPos(void) const { pos = 0; }
-    void clear(void) { buffer.clear();  pos = 0; }
+    void clear(void) { buffer.clear(); view = nullptr; viewSize = 0; pos = 0; }
+
+    // Owned storage only: throws std::logic_error on a view (see isView()),
+    // use bytes() and size() to read either kind.
+    const std::vector<uint8_t>& data(void) const {
+        ensureWritable();
+        return buffer;
+    }
 
     void insert(const uint8_t* src, std::size_t len) {
+        ensureWritable();
         buffer.insert(buffer.end(), src, src + len);
     }
-};
\ No newline at end of file
+
+    // Takes over bytes as the buffer's content.
+    void assign(std::vector<uint8_t> bytes) {
+        buffer = std::move(bytes);
+        view = nullptr;
+        viewSize = 0;
+        pos = 0;
+    }
+
+    // The memory must stay valid and unchanged while the view is in use.
+    void wrap(const uint8_t* src, std::size_t len) {
+        buffer.clear();
+        view = src;
+        viewSize = len;
+        pos = 0;
+    }
+
+    // Copies a view's bytes into owned storage, keeping the read position.
+    void own(void) {
+        if (!view) return;
+        buffer.assign(view, view + viewSize);
+        view = nullptr;
+        viewSize = 0;
+    }
+};
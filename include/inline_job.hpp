@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Move-only `void()` callable. Callables up to TCapacity bytes that can be
+// moved without throwing are stored in place; larger ones fall back to a
+// single heap allocation.
+template<std::size_t TCapacity>
+class InlineJob {
+private:
+    struct VTable {
+        void (*run)(void* storage);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename TFunc>
+    static constexpr bool storedInline = sizeof(TFunc) <= TCapacity
+        && alignof(TFunc) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible_v<TFunc>;
+
+    template<typename TFunc>
+    static const VTable* inlineTable() {
+        static const VTable table = {
+            [](void* s) { (*static_cast<TFunc*>(s))(); },
+            [](void* dst, void* src) noexcept {
+                new (dst) TFunc(std::move(*static_cast<TFunc*>(src)));
+                static_cast<TFunc*>(src)->~TFunc();
+            },
+            [](void* s) noexcept { static_cast<TFunc*>(s)->~TFunc(); }
+        };
+        return &table;
+    }
+
+    template<typename TFunc>
+    static const VTable* heapTable() {
+        static const VTable table = {
+            [](void* s) { (**static_cast<TFunc**>(s))(); },
+            [](void* dst, void* src) noexcept {
+                *static_cast<TFunc**>(dst) = *static_cast<TFunc**>(src);
+            },
+            [](void* s) noexcept { delete *static_cast<TFunc**>(s); }
+        };
+        return &table;
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[TCapacity < sizeof(void*) ? sizeof(void*) : TCapacity];
+    const VTable* vtable_ = nullptr;
+
+public:
+    static constexpr std::size_t capacity = TCapacity;
+
+    InlineJob() noexcept = default;
+
+    template<typename TFunc, typename = std::enable_if_t<!std::is_same_v<std::decay_t<TFunc>, InlineJob>>>
+    InlineJob(TFunc&& func) {
+        using Func = std::decay_t<TFunc>;
+        if constexpr (storedInline<Func>) {
+            new (storage_) Func(std::forward<TFunc>(func));
+            vtable_ = inlineTable<Func>();
+        } else {
+            *reinterpret_cast<Func**>(storage_) = new Func(std::forward<TFunc>(func));
+            vtable_ = heapTable<Func>();
+        }
+    }
+
+    InlineJob(InlineJob&& other) noexcept : vtable_(other.vtable_) {
+        if (vtable_) {
+            vtable_->move(storage_, other.storage_);
+            other.vtable_ = nullptr;
+        }
+    }
+
+    InlineJob& operator=(InlineJob&& other) noexcept {
+        if (this != &other) {
+            reset();
+            vtable_ = other.vtable_;
+            if (vtable_) {
+                vtable_->move(storage_, other.storage_);
+                other.vtable_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InlineJob(const InlineJob&) = delete;
+    InlineJob& operator=(const InlineJob&) = delete;
+
+    ~InlineJob() {
+        reset();
+    }
+
+    void run() {
+        if (vtable_) vtable_->run(storage_);
+    }
+
+    explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+    template<typename TFunc>
+    static constexpr bool fitsInline() { return storedInline<std::decay_t<TFunc>>; }
+
+private:
+    void reset() noexcept {
+        if (vtable_) {
+            vtable_->destroy(storage_);
+            vtable_ = nullptr;
+        }
+    }
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Bounded multi-producer / multi-consumer ring buffer (Vyukov). Each cell
+// carries a sequence number telling producers and consumers whose turn it
+// is, so push and pop are a single CAS on head or tail in the common case.
+// Capacity is rounded up to a power of two.
+template<typename TType>
+class LockFreeQueue {
+    static_assert(std::is_nothrow_move_constructible_v<TType>,
+                  "a claimed cell cannot be given back, moving into it must not throw");
+private:
+    static constexpr std::size_t cacheLineSize = 64;
+
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        alignas(TType) unsigned char storage[sizeof(TType)];
+
+        TType* value() { return reinterpret_cast<TType*>(storage); }
+    };
+
+    Cell*       cells_;
+    std::size_t mask_;
+
+    alignas(cacheLineSize) std::atomic<std::size_t> tail_{0};
+    alignas(cacheLineSize) std::atomic<std::size_t> head_{0};
+
+    static std::size_t roundUp(std::size_t n) {
+        std::size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    template<typename TArg>
+    bool enqueue(TArg&& value) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    new (cell.value()) TType(std::forward<TArg>(value));
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template<typename TConsume>
+    bool dequeue(TConsume&& consume) {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    consume(std::move(*cell.value()));
+                    cell.value()->~TType();
+                    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+public:
+    explicit LockFreeQueue(std::size_t capacity = 1024)
+        : mask_(roundUp(capacity) - 1) {
+        cells_ = static_cast<Cell*>(operator new[]((mask_ + 1) * sizeof(Cell), std::align_val_t(alignof(Cell))));
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            new (&cells_[i].sequence) std::atomic<std::size_t>(i);
+        }
+    }
+
+    ~LockFreeQueue() {
+        while (dequeue([](TType&&) {})) {}
+        operator delete[](cells_, std::align_val_t(alignof(Cell)));
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    std::size_t capacity(void) const { return mask_ + 1; }
+
+    bool try_push(const TType& newElement) {
+        TType copy(newElement);
+        return enqueue(std::move(copy));
+    }
+    bool try_push(TType&& newElement) { return enqueue(std::move(newElement)); }
+
+    // The value is moved out of its cell and the cell released before it is
+    // assigned to out, so a throwing move assignment cannot wedge the ring.
+    bool try_pop(TType& out) {
+        std::optional<TType> t;
+        if (!dequeue([&t](TType&& value) { t.emplace(std::move(value)); })) return false;
+        out = std::move(*t);
+        return true;
+    }
+
+    void push_back(const TType& newElement) {
+        if (!try_push(newElement)) {
+            throw std::runtime_error("push on full queue");
+        }
+    }
+
+    void push_back(TType&& newElement) {
+        if (!try_push(std::move(newElement))) {
+            throw std::runtime_error("push on full queue");
+        }
+    }
+
+    TType pop_front(void) {
+        std::optional<TType> t;
+        if (!dequeue([&t](TType&& value) { t.emplace(std::move(value)); })) {
+            throw std::runtime_error("pop on empty queue");
+        }
+        return std::move(*t);
+    }
+
+    // Only a snapshot when other threads are pushing or popping.
+    bool empty(void) const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+};
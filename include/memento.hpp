@@ -1,24 +1,123 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "data_buffer.hpp"
+#include "snapshot_codec.hpp"
 
 class Memento {
 public:
     class Snapshot : public DataBuffer {
         friend Memento;
+        friend class SnapshotStore;
+
+        bool compressed_ = false;
+
+    public:
+        bool isCompressed(void) const {
+            return compressed_;
+        }
     };
 
+    enum class Compression { None, Fast };
+
+    // Fills a snapshot later, possibly on another thread.
+    using Capture = std::function<void(Snapshot&)>;
+
     Snapshot save() const {
         Snapshot snapshot;
         this->_saveToSnapshot(snapshot);
         return snapshot;
     }
 
+    // Compressed snapshots are expanded first.
     void load(Snapshot& state) {
+        if (state.isCompressed()) {
+            Snapshot expanded = decompress(state);
+            this->_loadFromSnapshot(expanded);
+            return;
+        }
         this->_loadFromSnapshot(state);
     }
 
+    // Runs _captureForSave() on the caller and the rest on a pool thread,
+    // e.g. WorkerPool, returning its future. The default capture calls
+    // save() on the caller, so only compression is moved off it; override
+    // _captureForSave() (see CopyOnWrite) to move serialization too.
+    template<typename TPool>
+    auto saveAsync(TPool& pool, Compression compression = Compression::None) const {
+        Capture capture = this->_captureForSave();
+        return pool.submit([capture, compression]() {
+            Snapshot snapshot;
+            capture(snapshot);
+            if (compression == Compression::Fast) return compress(snapshot);
+            return snapshot;
+        });
+    }
+
+    static Snapshot compress(const Snapshot& snapshot) {
+        if (snapshot.isCompressed()) return snapshot;
+        std::vector<uint8_t> bytes;
+        SnapshotCodec::compress(snapshot.bytes(), snapshot.size(), bytes);
+        Snapshot result;
+        result.assign(std::move(bytes));
+        result.compressed_ = true;
+        return result;
+    }
+
+    static Snapshot decompress(const Snapshot& snapshot) {
+        if (!snapshot.isCompressed()) return snapshot;
+        std::vector<uint8_t> bytes;
+        SnapshotCodec::decompress(snapshot.bytes(), snapshot.size(), bytes);
+        Snapshot result;
+        result.assign(std::move(bytes));
+        return result;
+    }
+
 protected:
     virtual void _saveToSnapshot(Snapshot&) const = 0;
     virtual void _loadFromSnapshot(Snapshot&) = 0;
-};
\ No newline at end of file
+
+    // What saveAsync() takes from the object on the calling thread. The
+    // default serializes right away; objects keeping their state in
+    // CopyOnWrite members can capture shared references instead and leave
+    // the serialization to the pool.
+    virtual Capture _captureForSave() const {
+        auto snapshot = std::make_shared<Snapshot>(save());
+        return [snapshot](Snapshot& out) { out = std::move(*snapshot); };
+    }
+};
+
+// Value shared with in-flight captures. write() copies it first if a capture
+// still holds the current version, so a capture keeps seeing the state as it
+// was when taken. Reads and writes belong to one thread; captures can be
+// read from any thread.
+template<typename TType>
+class CopyOnWrite {
+private:
+    std::shared_ptr<TType> value_;
+
+public:
+    CopyOnWrite(void) : value_(std::make_shared<TType>()) {}
+    explicit CopyOnWrite(TType value) : value_(std::make_shared<TType>(std::move(value))) {}
+
+    const TType& read(void) const { return *value_; }
+    const TType& operator*(void) const { return *value_; }
+    const TType* operator->(void) const { return value_.get(); }
+
+    TType& write(void) {
+        if (value_.use_count() != 1) {
+            value_ = std::make_shared<TType>(*value_);
+        } else {
+            // Pairs with the release in the last capture's reference drop.
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *value_;
+    }
+
+    std::shared_ptr<const TType> share(void) const { return value_; }
+};
@@ -2,13 +2,41 @@
 
 #include "data_buffer.hpp"
 #include <cstddef>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
 
 class Message {
 public:
     using Type = int;
+    static constexpr std::size_t headerSize = 8;
+
+    // A peer closing its socket turns into EPIPE instead of SIGPIPE.
+#ifdef MSG_NOSIGNAL
+    static constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+    static constexpr int sendFlags = 0;
+#endif
+
+    class Frame;
 
     Message(int type) : type_(type) {}
 
+    // A copy always owns its payload, even when copied from a view.
+    Message(const Message& other) : type_(other.type_), buffer_(other.buffer_) {
+        buffer_.own();
+    }
+
+    Message& operator=(const Message& other) {
+        type_ = other.type_;
+        buffer_ = other.buffer_;
+        buffer_.own();
+        return *this;
+    }
+
+    Message(Message&&) = default;
+    Message& operator=(Message&&) = default;
+
     template<typename T>
     Message& operator<<(const T& value) {
         buffer_ << value;
@@ -23,39 +51,59 @@ public:
 
     Type type(void) const { return type_; }
 
+    // ——— Vue [header|payload] sans copie, pour writev ———
+    Frame frame() const;
+
     // ——— Empaqueter en trame [type|length|payload] ———
     std::vector<uint8_t> raw() const {
         std::vector<uint8_t> frame;
-        frame.reserve(8 + buffer_.size());
+        frame.reserve(headerSize + buffer_.size());
 
         appendUInt32BE(frame, static_cast<uint32_t>(type_));
         appendUInt32BE(frame, static_cast<uint32_t>(buffer_.size()));
-
-        std::vector<uint8_t> buffer = buffer_.data();
-        frame.insert(frame.end(), buffer.begin(), buffer.end());
+        frame.insert(frame.end(), buffer_.bytes(), buffer_.bytes() + buffer_.size());
 
         return frame;
     }
 
     // ——— Dépaqueter une trame brute en Message ———
     static Message fromRaw(const std::vector<uint8_t>& frame) {
-        if (frame.size() < 8)
+        return fromRaw(frame.data(), frame.size());
+    }
+
+    static Message fromRaw(const uint8_t* frame, std::size_t size) {
+        if (size < headerSize)
             throw std::runtime_error("Frame too short");
 
-        uint32_t    netType   = readUInt32BE(frame.data());
-        uint32_t    netLength = readUInt32BE(frame.data() + 4);
+        uint32_t    netType   = readUInt32BE(frame);
+        uint32_t    netLength = readUInt32BE(frame + 4);
         std::size_t payloadSz = static_cast<size_t>(netLength);
 
-        if (frame.size() < 8 + payloadSz)
+        if (size < headerSize + payloadSz)
             throw std::runtime_error("Incomplete frame");
 
         Message msg(static_cast<Type>(netType));
-        msg.buffer_.insert(frame.data() + 8, payloadSz);
+        msg.buffer_.insert(frame + headerSize, payloadSz);
         msg.buffer_.resetReadPos();
 
         return msg;
     }
 
+    // Comme fromRaw, mais le payload est lu en place dans `frame`, qui doit
+    // rester valide tant que le Message (pas ses copies) est utilise.
+    static Message viewRaw(const uint8_t* frame, std::size_t size) {
+        if (size < headerSize)
+            throw std::runtime_error("Frame too short");
+
+        std::size_t payloadSz = static_cast<size_t>(readUInt32BE(frame + 4));
+        if (size < headerSize + payloadSz)
+            throw std::runtime_error("Incomplete frame");
+
+        Message msg(static_cast<Type>(readUInt32BE(frame)));
+        msg.buffer_.wrap(frame + headerSize, payloadSz);
+        return msg;
+    }
+
     static void appendUInt32BE(std::vector<uint8_t>& buf, uint32_t v) {
         buf.push_back(uint8_t((v >> 24) & 0xFF));
         buf.push_back(uint8_t((v >> 16) & 0xFF));
@@ -73,4 +121,82 @@ public:
 private:
     Type type_;
     mutable DataBuffer buffer_;
-};
\ No newline at end of file
+};
+
+// Header and payload as two iovecs pointing at the message's own storage.
+// The Message must outlive its Frame.
+class Message::Frame {
+public:
+    explicit Frame(const Message& message) {
+        const DataBuffer& payload = message.buffer_;
+        writeUInt32BE(header_, static_cast<uint32_t>(message.type_));
+        writeUInt32BE(header_ + 4, static_cast<uint32_t>(payload.size()));
+
+        iov_[0].iov_base = header_;
+        iov_[0].iov_len  = headerSize;
+        iov_[1].iov_base = const_cast<uint8_t*>(payload.bytes());
+        iov_[1].iov_len  = payload.size();
+        first_ = 0;
+        count_ = payload.size() == 0 ? 1 : 2;
+    }
+
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+
+    const iovec* iov(void) const { return iov_ + first_; }
+    int iovcnt(void) const { return count_ - first_; }
+    bool done(void) const { return first_ == count_; }
+
+    std::size_t remaining(void) const {
+        std::size_t left = 0;
+        for (int i = first_; i < count_; ++i) left += iov_[i].iov_len;
+        return left;
+    }
+
+    // Un seul sendmsg pour ce qui reste a envoyer, retourne comme ::sendmsg.
+    ssize_t writeTo(int fd) {
+        msghdr msg{};
+        msg.msg_iov    = iov_ + first_;
+        msg.msg_iovlen = static_cast<std::size_t>(iovcnt());
+        ssize_t n = ::sendmsg(fd, &msg, sendFlags);
+        if (n > 0) consume(static_cast<std::size_t>(n));
+        return n;
+    }
+
+    void consume(std::size_t n) {
+        while (n > 0 && first_ < count_) {
+            iovec& v = iov_[first_];
+            std::size_t step = n < v.iov_len ? n : v.iov_len;
+            v.iov_base = static_cast<uint8_t*>(v.iov_base) + step;
+            v.iov_len -= step;
+            n -= step;
+            if (v.iov_len == 0) ++first_;
+        }
+    }
+
+    // Copie ce qui n'a pas ete envoye, seulement quand le socket bloque.
+    void appendRemaining(std::vector<uint8_t>& out) const {
+        out.reserve(out.size() + remaining());
+        for (int i = first_; i < count_; ++i) {
+            const uint8_t* p = static_cast<const uint8_t*>(iov_[i].iov_base);
+            out.insert(out.end(), p, p + iov_[i].iov_len);
+        }
+    }
+
+private:
+    static void writeUInt32BE(uint8_t* p, uint32_t v) {
+        p[0] = uint8_t((v >> 24) & 0xFF);
+        p[1] = uint8_t((v >> 16) & 0xFF);
+        p[2] = uint8_t((v >>  8) & 0xFF);
+        p[3] = uint8_t((v      ) & 0xFF);
+    }
+
+    uint8_t header_[headerSize];
+    iovec   iov_[2];
+    int     first_;
+    int     count_;
+};
+
+inline Message::Frame Message::frame() const {
+    return Frame(*this);
+}
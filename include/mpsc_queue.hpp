@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+// Unbounded multi-producer / single-consumer queue (Vyukov intrusive list).
+// push is wait-free, try_pop must only be called from the consumer thread.
+template<typename TType>
+class MpscQueue {
+private:
+    struct Node {
+        std::atomic<Node*>      next{nullptr};
+        std::optional<TType>    value;
+    };
+
+    std::atomic<Node*> head_;
+    Node*              tail_;
+
+public:
+    MpscQueue(void) {
+        Node* stub = new Node();
+        head_.store(stub, std::memory_order_relaxed);
+        tail_ = stub;
+    }
+
+    ~MpscQueue(void) {
+        while (tail_) {
+            Node* next = tail_->next.load(std::memory_order_relaxed);
+            delete tail_;
+            tail_ = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(TType value) {
+        Node* node = new Node();
+        node->value.emplace(std::move(value));
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    std::optional<TType> try_pop(void) {
+        Node* next = tail_->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return std::nullopt;
+        }
+        std::optional<TType> value(std::move(next->value));
+        next->value.reset();
+        delete tail_;
+        tail_ = next;
+        return value;
+    }
+
+    bool empty(void) const {
+        return tail_->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
@@ -1,3 +1,4 @@
 #include "message.hpp"
 #include "client.hpp"
-#include "server.hpp"
\ No newline at end of file
+#include "server.hpp"
+#include "sharded_server.hpp"
\ No newline at end of file
@@ -1,21 +1,225 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <map>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-template<typename TEvent>
+template<typename TPayload>
+struct ObserverCallback {
+    using type = std::function<void(const TPayload&)>;
+};
+
+template<>
+struct ObserverCallback<void> {
+    using type = std::function<void()>;
+};
+
+// Event bus with an optional typed payload: Observer<Event> callbacks take
+// nothing, Observer<Event, Payload> callbacks take a const Payload&.
+// Subscribers of one event sit in a contiguous vector; enum and integer
+// events find it by direct index, other event types through a map lookup
+// (never an insertion). notify() does not allocate. Callbacks may subscribe
+// and unsubscribe while a notify() is running; those changes are applied
+// once the outermost notify() returns. Not thread-safe.
+template<typename TEvent, typename TPayload = void>
 class Observer {
-private:
-    std::map<TEvent, std::vector<std::function<void()>>> registry;
 public:
-    void subscribe(const TEvent& event, const std::function<void()>& lambda) {
-        registry[event].push_back(lambda);
+    using Callback = typename ObserverCallback<TPayload>::type;
+    using SubscriptionId = uint64_t;
+
+    static constexpr SubscriptionId invalidSubscription = 0;
+
+    Observer(void) = default;
+    Observer(const Observer&) = delete;
+    Observer& operator=(const Observer&) = delete;
+
+    SubscriptionId subscribe(const TEvent& event, Callback callback) {
+        uint32_t index = acquireHandle();
+        if (dispatching_ > 0) {
+            pending_.push_back({index, event, std::move(callback)});
+        } else {
+            attach(index, channelFor(event), std::move(callback));
+        }
+        return (static_cast<SubscriptionId>(handles_[index].generation) << 32) | (index + 1);
+    }
+
+    // Returns false if the id is unknown or already unsubscribed.
+    bool unsubscribe(SubscriptionId id) {
+        uint32_t index = static_cast<uint32_t>(id & 0xFFFFFFFFu) - 1;
+        if (id == invalidSubscription || index >= handles_.size()) return false;
+        Handle& handle = handles_[index];
+        if (!handle.active || handle.generation != static_cast<uint32_t>(id >> 32)) return false;
+        handle.active = false;
+        if (dispatching_ > 0) {
+            if (handle.position != detached) {
+                channels_[handle.channel][handle.position].live = false;
+            }
+            doomed_.push_back(index);
+        } else {
+            detach(index);
+        }
+        return true;
     }
 
     void notify(const TEvent& event) {
-        for (const auto& lambda : registry[event]) {
-            lambda();
+        static_assert(std::is_void_v<TPayload>, "this Observer needs a payload");
+        dispatch(event);
+    }
+
+    template<typename P = TPayload>
+    void notify(const TEvent& event, const std::enable_if_t<!std::is_void_v<P>, P>& payload) {
+        dispatch(event, payload);
+    }
+
+    std::size_t subscriberCount(const TEvent& event) const {
+        std::size_t channel = findChannel(event);
+        return channel == npos ? 0 : channels_[channel].size();
+    }
+
+private:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+    static constexpr uint32_t detached = std::numeric_limits<uint32_t>::max();
+    static constexpr long long maxDenseEvent = 1 << 16;
+
+    struct Subscriber {
+        uint32_t handle;
+        bool     live;
+        Callback callback;
+    };
+
+    struct Handle {
+        uint32_t channel = 0;
+        uint32_t position = detached;
+        uint32_t generation = 0;
+        bool     active = false;
+    };
+
+    struct Pending {
+        uint32_t handle;
+        TEvent   event;
+        Callback callback;
+    };
+
+    // Restores the dispatch depth even if a callback throws.
+    struct DispatchScope {
+        Observer& owner;
+        explicit DispatchScope(Observer& o) : owner(o) { ++owner.dispatching_; }
+        ~DispatchScope() {
+            if (--owner.dispatching_ == 0 && (!owner.pending_.empty() || !owner.doomed_.empty())) {
+                owner.settle();
+            }
+        }
+    };
+
+    std::vector<std::vector<Subscriber>> channels_;
+    std::vector<std::size_t>             denseIndex_;   // event value -> channel + 1
+    std::map<TEvent, std::size_t>        sparseIndex_;  // events outside the dense range
+    std::vector<Handle>                  handles_;
+    std::vector<uint32_t>                freeHandles_;
+    std::vector<Pending>                 pending_;
+    std::vector<uint32_t>                doomed_;
+    int                                  dispatching_ = 0;
+
+    template<typename... TArgs>
+    void dispatch(const TEvent& event, const TArgs&... payload) {
+        std::size_t channel = findChannel(event);
+        if (channel == npos) return;
+        DispatchScope scope(*this);
+        // Nothing is added to or removed from channels_ until the scope ends.
+        for (const Subscriber& subscriber : channels_[channel]) {
+            if (subscriber.live) subscriber.callback(payload...);
+        }
+    }
+
+    static bool isDense(const TEvent& event, long long& value) {
+        if constexpr (std::is_enum_v<TEvent> || std::is_integral_v<TEvent>) {
+            value = static_cast<long long>(event);
+            return value >= 0 && value < maxDenseEvent;
+        } else {
+            (void)event;
+            (void)value;
+            return false;
+        }
+    }
+
+    std::size_t findChannel(const TEvent& event) const {
+        long long value;
+        if (isDense(event, value)) {
+            std::size_t slot = static_cast<std::size_t>(value);
+            return slot < denseIndex_.size() ? denseIndex_[slot] - 1 : npos;
+        }
+        auto it = sparseIndex_.find(event);
+        return it == sparseIndex_.end() ? npos : it->second - 1;
+    }
+
+    std::size_t channelFor(const TEvent& event) {
+        std::size_t channel = findChannel(event);
+        if (channel != npos) return channel;
+        channel = channels_.size();
+        channels_.emplace_back();
+        long long value;
+        if (isDense(event, value)) {
+            std::size_t slot = static_cast<std::size_t>(value);
+            if (slot >= denseIndex_.size()) denseIndex_.resize(slot + 1, 0);
+            denseIndex_[slot] = channel + 1;
+        } else {
+            sparseIndex_[event] = channel + 1;
+        }
+        return channel;
+    }
+
+    uint32_t acquireHandle(void) {
+        uint32_t index;
+        if (!freeHandles_.empty()) {
+            index = freeHandles_.back();
+            freeHandles_.pop_back();
+        } else {
+            index = static_cast<uint32_t>(handles_.size());
+            handles_.emplace_back();
+        }
+        handles_[index].active = true;
+        handles_[index].position = detached;
+        return index;
+    }
+
+    void attach(uint32_t index, std::size_t channel, Callback callback) {
+        std::vector<Subscriber>& subscribers = channels_[channel];
+        handles_[index].channel = static_cast<uint32_t>(channel);
+        handles_[index].position = static_cast<uint32_t>(subscribers.size());
+        subscribers.push_back({index, true, std::move(callback)});
+    }
+
+    // Swap-and-pop, so subscribers of one event are not kept in order.
+    void detach(uint32_t index) {
+        Handle& handle = handles_[index];
+        if (handle.position != detached) {
+            std::vector<Subscriber>& subscribers = channels_[handle.channel];
+            if (handle.position + 1 != subscribers.size()) {
+                subscribers[handle.position] = std::move(subscribers.back());
+                handles_[subscribers[handle.position].handle].position = handle.position;
+            }
+            subscribers.pop_back();
+        }
+        handle.position = detached;
+        ++handle.generation;
+        freeHandles_.push_back(index);
+    }
+
+    void settle(void) {
+        std::vector<Pending> pending;
+        pending.swap(pending_);
+        for (Pending& p : pending) {
+            attach(p.handle, channelFor(p.event), std::move(p.callback));
+        }
+        std::vector<uint32_t> doomed;
+        doomed.swap(doomed_);
+        for (uint32_t index : doomed) {
+            detach(index);
         }
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "worker_pool.hpp"
+
+// Hands out chunks of [first, last) on demand. Chunks start large and
+// shrink as the range drains (guided scheduling), never below grain, so
+// uneven iterations still balance at the end without paying per-index
+// overhead at the start.
+class ParallelRange {
+public:
+    ParallelRange(std::size_t first, std::size_t last, std::size_t grain, std::size_t participants)
+        : next_(first), last_(last), grain_(grain), participants_(participants) {}
+
+    bool next(std::size_t& begin, std::size_t& end) {
+        std::size_t current = next_.load(std::memory_order_relaxed);
+        while (current < last_) {
+            std::size_t remaining = last_ - current;
+            std::size_t chunk = std::max(grain_, remaining / (2 * participants_));
+            std::size_t stop = current + std::min(chunk, remaining);
+            if (next_.compare_exchange_weak(current, stop, std::memory_order_relaxed)) {
+                begin = current;
+                end = stop;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Stops handing out chunks and returns how many indices were left.
+    std::size_t cancel() {
+        std::size_t current = next_.exchange(last_, std::memory_order_relaxed);
+        return current < last_ ? last_ - current : 0;
+    }
+
+private:
+    std::atomic<std::size_t> next_;
+    std::size_t              last_;
+    std::size_t              grain_;
+    std::size_t              participants_;
+};
+
+// Runs body(begin, end) over chunks of [first, last) on the pool workers and
+// the calling thread, and returns once every index has been processed. The
+// first exception thrown by body cancels the remaining chunks and is
+// rethrown here.
+template<typename TBody>
+void parallel_chunks(WorkerPool& pool, std::size_t first, std::size_t last, std::size_t grain, TBody&& body) {
+    if (first >= last) return;
+    std::size_t count = last - first;
+    std::size_t participants = pool.size() + 1;
+    if (grain == 0) {
+        grain = std::max<std::size_t>(1, count / (participants * 64));
+    }
+    if (pool.size() == 0 || count <= grain) {
+        body(first, last);
+        return;
+    }
+
+    struct Shared {
+        ParallelRange               range;
+        std::atomic<std::size_t>    pending;
+        void                        (*run)(void*, std::size_t, std::size_t);
+        void*                       body;
+        std::mutex                  mutex;
+        std::condition_variable     cv;
+        std::exception_ptr          error;
+
+        Shared(std::size_t f, std::size_t l, std::size_t g, std::size_t p)
+            : range(f, l, g, p), pending(l - f) {}
+
+        void complete(std::size_t n) {
+            if (pending.fetch_sub(n, std::memory_order_acq_rel) == n) {
+                std::lock_guard<std::mutex> lock(mutex);
+                cv.notify_all();
+            }
+        }
+
+        void work() {
+            std::size_t begin, end;
+            while (range.next(begin, end)) {
+                try {
+                    run(body, begin, end);
+                } catch (...) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!error) error = std::current_exception();
+                    }
+                    std::size_t skipped = range.cancel();
+                    if (skipped) complete(skipped);
+                }
+                complete(end - begin);
+            }
+        }
+    };
+
+    using Body = std::remove_reference_t<TBody>;
+    auto shared = std::make_shared<Shared>(first, last, grain, participants);
+    shared->body = const_cast<void*>(static_cast<const void*>(std::addressof(body)));
+    shared->run = [](void* b, std::size_t begin, std::size_t end) {
+        (*static_cast<Body*>(b))(begin, end);
+    };
+
+    // Helpers that start after the range is drained find nothing to claim
+    // and never touch body, so they may safely outlive this call.
+    std::size_t helpers = std::min(pool.size(), (count + grain - 1) / grain - 1);
+    for (std::size_t i = 0; i < helpers; ++i) {
+        pool.addJob([shared]() { shared->work(); });
+    }
+    shared->work();
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(shared->mutex);
+        shared->cv.wait(lock, [&shared] {
+            return shared->pending.load(std::memory_order_acquire) == 0;
+        });
+        error = std::move(shared->error);
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+// Calls func(i) for every i in [first, last). grain is the smallest chunk
+// a participant takes at once, 0 picks one from the range size.
+template<typename TFunc>
+void parallel_for(WorkerPool& pool, std::size_t first, std::size_t last, TFunc&& func, std::size_t grain = 0) {
+    parallel_chunks(pool, first, last, grain, [&func](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) func(i);
+    });
+}
+
+// Folds map(i) over [first, last) with join, starting from identity.
+// join must be associative and commutative: chunks are combined in
+// completion order.
+template<typename TValue, typename TMap, typename TJoin>
+TValue parallel_reduce(WorkerPool& pool, std::size_t first, std::size_t last, TValue identity,
+                       TMap&& map, TJoin&& join, std::size_t grain = 0) {
+    TValue result = identity;
+    std::mutex mutex;
+    parallel_chunks(pool, first, last, grain, [&](std::size_t begin, std::size_t end) {
+        TValue partial = identity;
+        for (std::size_t i = begin; i < end; ++i) {
+            partial = join(std::move(partial), map(i));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        result = join(std::move(result), std::move(partial));
+    });
+    return result;
+}
+
+// Sorts runs of the range in parallel, then merges them pairwise, each
+// round of merges running in parallel. Not stable.
+template<typename TIterator, typename TCompare = std::less<>>
+void parallel_sort(WorkerPool& pool, TIterator first, TIterator last, TCompare comp = TCompare()) {
+    static constexpr std::size_t minRun = 4096;
+    std::size_t count = static_cast<std::size_t>(std::distance(first, last));
+
+    std::size_t runs = 1;
+    while (runs < pool.size() + 1 && count / (runs * 2) >= minRun) runs *= 2;
+    if (runs == 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    std::vector<TIterator> bounds;
+    bounds.reserve(runs + 1);
+    for (std::size_t i = 0; i <= runs; ++i) {
+        bounds.push_back(first + static_cast<std::ptrdiff_t>(count * i / runs));
+    }
+
+    parallel_for(pool, 0, runs, [&](std::size_t i) {
+        std::sort(bounds[i], bounds[i + 1], comp);
+    }, 1);
+    for (std::size_t width = 1; width < runs; width *= 2) {
+        parallel_for(pool, 0, runs / (2 * width), [&](std::size_t k) {
+            std::size_t lo = k * 2 * width;
+            std::inplace_merge(bounds[lo], bounds[lo + width], bounds[lo + 2 * width], comp);
+        }, 1);
+    }
+}
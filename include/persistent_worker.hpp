@@ -1,41 +1,173 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <string>
 #include <functional>
 #include <map>
+#include <memory>
 #include <thread>
 #include <mutex>
+#include <vector>
 
+// Runs named tasks on one background thread, each at its own period or
+// once at a deadline. Deadlines are kept in a min-heap and the thread
+// sleeps until the earliest one. Tasks run without the lock held, so
+// addTask/removeTask never wait for a running task; removing a task does
+// not interrupt a run that already started.
 class PersistentWorker {
 public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr Clock::duration defaultPeriod = std::chrono::milliseconds(100);
+
     PersistentWorker(void) : thread([this] { this->workerLoop(); }) {}
+
     ~PersistentWorker(void) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
         if (thread.joinable()) {
             thread.join();
         }
     }
 
-    void addTask(const std::string& name, const std::function<void()>& jobToExecute) {
-        std::lock_guard<std::mutex> lock(mutex);
-        tasks[name] = jobToExecute;
+    PersistentWorker(const PersistentWorker&) = delete;
+    PersistentWorker& operator=(const PersistentWorker&) = delete;
+
+    // Runs jobToExecute every period, the first time right away. Replaces
+    // any task with the same name.
+    void addTask(const std::string& name, const std::function<void()>& jobToExecute,
+                 Clock::duration period = defaultPeriod) {
+        schedule(name, jobToExecute, Clock::now(), std::max(period, Clock::duration(1)));
+    }
+
+    // Runs jobToExecute once at deadline, then forgets it.
+    void addTaskAt(const std::string& name, const std::function<void()>& jobToExecute,
+                   Clock::time_point deadline) {
+        schedule(name, jobToExecute, deadline, Clock::duration::zero());
     }
 
     void removeTask(const std::string& name) {
         std::lock_guard<std::mutex> lock(mutex);
-        tasks.erase(name);
+        auto it = tasks.find(name);
+        if (it == tasks.end()) return;
+        if (it->second.queued) ++stale;
+        tasks.erase(it);
     }
 
 private:
-    void workerLoop(void) {
-        while (true) {
+    struct Task {
+        uint64_t                                id;
+        std::shared_ptr<std::function<void()>>  job;
+        Clock::duration                         period;     // zero for one-shot tasks
+        bool                                    queued;     // has an entry in the heap, false while running
+    };
+
+    struct Entry {
+        Clock::time_point   deadline;
+        uint64_t            id;
+        std::string         name;
+
+        bool operator>(const Entry& other) const { return deadline > other.deadline; }
+    };
+
+    void schedule(const std::string& name, const std::function<void()>& job,
+                  Clock::time_point deadline, Clock::duration period) {
+        bool wake;
+        {
             std::lock_guard<std::mutex> lock(mutex);
-            for (const auto& [name, task] : tasks) {
-                task();
+            uint64_t id = nextId++;
+            auto it = tasks.find(name);
+            if (it != tasks.end()) {
+                if (it->second.queued) ++stale;
+                it->second = Task{id, std::make_shared<std::function<void()>>(job), period, true};
+            } else {
+                tasks.emplace(name, Task{id, std::make_shared<std::function<void()>>(job), period, true});
+            }
+            wake = heap.empty() || deadline < heap.front().deadline;
+            pushEntry(Entry{deadline, id, name});
+        }
+        if (wake) condition.notify_one();
+    }
+
+    void pushEntry(Entry entry) {
+        heap.push_back(std::move(entry));
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    }
+
+    // Entries of removed or replaced tasks are skipped lazily; rebuild the
+    // heap when they make up most of it. stale counts exactly those entries.
+    void compact(void) {
+        if (stale <= heap.size() / 2) return;
+        heap.erase(std::remove_if(heap.begin(), heap.end(), [this](const Entry& e) {
+            auto it = tasks.find(e.name);
+            return it == tasks.end() || it->second.id != e.id;
+        }), heap.end());
+        std::make_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        stale = 0;
+    }
+
+    void workerLoop(void) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            compact();
+            if (heap.empty()) {
+                condition.wait(lock);
+                continue;
+            }
+            if (Clock::now() < heap.front().deadline) {
+                condition.wait_until(lock, heap.front().deadline);
+                continue;
+            }
+
+            std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+            Entry entry = std::move(heap.back());
+            heap.pop_back();
+
+            auto it = tasks.find(entry.name);
+            if (it == tasks.end() || it->second.id != entry.id) {
+                --stale;
+                continue;
+            }
+            std::shared_ptr<std::function<void()>> job = it->second.job;
+            Clock::duration period = it->second.period;
+            if (period == Clock::duration::zero()) {
+                tasks.erase(it);
+            } else {
+                it->second.queued = false;
+            }
+
+            lock.unlock();
+            try {
+                (*job)();
+            } catch (...) {}
+            lock.lock();
+
+            // Reschedule unless the task was removed or replaced meanwhile.
+            // Missed periods are skipped rather than run back to back.
+            it = tasks.find(entry.name);
+            if (period != Clock::duration::zero() && it != tasks.end() && it->second.id == entry.id) {
+                Clock::time_point next = entry.deadline + period;
+                Clock::time_point now = Clock::now();
+                if (next <= now) next = now + period;
+                entry.deadline = next;
+                it->second.queued = true;
+                pushEntry(std::move(entry));
             }
         }
     }
 
-    std::thread thread;
-    std::mutex mutex;
-    std::map<std::string, std::function<void()>> tasks;
-};
\ No newline at end of file
+    std::mutex                      mutex;
+    std::condition_variable         condition;
+    std::map<std::string, Task>     tasks;
+    std::vector<Entry>              heap;
+    std::size_t                     stale = 0;
+    uint64_t                        nextId = 0;
+    bool                            stopping = false;
+    std::thread                     thread;
+};
@@ -2,122 +2,241 @@
 
 #include <cstddef>
 #include <cstdlib>
+#include <functional>
 #include <new>
+#include <type_traits>
 #include <utility>
 #include <algorithm>
-
-template<typename TType>
+#include <vector>
+
+// Free slots are chained through their own storage, so acquire and release
+// are O(1). TCacheAligned pads every slot to its own cache line.
+// Storage is a list of chunks that are never moved: resize() only adds or
+// drops whole chunks, so live objects keep their address. With a non-zero
+// growthChunk, acquire() adds a chunk of that many slots instead of
+// throwing std::bad_alloc when the pool is exhausted.
+template<typename TType, bool TCacheAligned = false>
 class Pool {
 public:
-    Pool() noexcept
-        : buffer(nullptr), free_list(nullptr), capacity(0) {}
+    static constexpr std::size_t cacheLineSize = 64;
+    static constexpr std::size_t slotAlign = std::max({
+        alignof(TType), alignof(void*), TCacheAligned ? cacheLineSize : std::size_t(1)
+    });
+    static constexpr std::size_t slotSize =
+        (std::max(sizeof(TType), sizeof(void*)) + slotAlign - 1) / slotAlign * slotAlign;
+
+    explicit Pool(std::size_t growthChunk = 0) noexcept
+        : free_head(nullptr), capacity(0), growth(growthChunk) {}
+    // Walks the chunks and the free list in address order, both sorted in
+    // place, so destroying the live objects never allocates.
     ~Pool() noexcept {
-        for (std::size_t i = 0; i < capacity; ++i) {
-            if (free_list[i] == false) {
-                char* base = static_cast<char*>(buffer);
-                TType* ptr = reinterpret_cast<TType*>(base + i * sizeof(TType));
-                ptr->~TType();
+        if constexpr (!std::is_trivially_destructible_v<TType>) {
+            std::sort(chunks.begin(), chunks.end(), [](const Chunk& a, const Chunk& b) {
+                return std::less<const char*>()(a.slots, b.slots);
+            });
+            FreeSlot* free = sortByAddress(free_head);
+            for (const Chunk& chunk : chunks) {
+                for (std::size_t i = 0; i < chunk.count; ++i) {
+                    if (free == reinterpret_cast<FreeSlot*>(chunk.slots + i * slotSize)) {
+                        free = free->next;
+                        continue;
+                    }
+                    objectAt(chunk.slots, i)->~TType();
+                }
             }
         }
-        delete[] free_list;
-        operator delete[](buffer);
+        for (const Chunk& chunk : chunks) {
+            deallocate(chunk.slots);
+        }
     }
-    
+
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
     class Object;
 
-    void resize(std::size_t newCap) {
-        void* newBuf   = operator new[](newCap * sizeof(TType));
-        bool* newFree  = new bool[newCap];
-        std::fill(newFree, newFree + newCap, true);
+    std::size_t size() const noexcept { return capacity; }
 
-        try {
-            for (std::size_t i = 0; i < capacity && i < newCap; ++i) {
-                if (!free_list[i]) {
-                    char* oldBase = static_cast<char*>(buffer);
-                    TType* oldPtr = reinterpret_cast<TType*>(oldBase + i * sizeof(TType));
-                    char* newBase = static_cast<char*>(newBuf);
-                    TType* newPtr = reinterpret_cast<TType*>(newBase + i * sizeof(TType));
-                    new (newPtr) TType(std::move(*oldPtr));
-                    newFree[i] = false;
-                    oldPtr->~TType();
-                }
-            }
-            for (std::size_t i = newCap; i < capacity; ++i) {
-                if (!free_list[i]) {
-                    char* base = static_cast<char*>(buffer);
-                    TType* ptr = reinterpret_cast<TType*>(base + i * sizeof(TType));
-                    ptr->~TType();
-                }
-            }
-        } catch(...) {
-            operator delete[](newBuf);
-            delete[] newFree;
-            throw;
+    // Growing appends one chunk. Shrinking only releases trailing chunks
+    // with no live object in them, so it may stop above newCap.
+    void resize(std::size_t newCap) {
+        if (newCap > capacity) {
+            addChunk(newCap - capacity);
+            return;
         }
 
-        if (buffer) {
-            operator delete[](buffer);
-            delete[] free_list;
+        std::vector<std::vector<bool>> live = liveSlots();
+        std::size_t keep = chunks.size();
+        std::size_t cap  = capacity;
+        while (keep > 0 && cap - chunks[keep - 1].count >= newCap
+               && std::none_of(live[keep - 1].begin(), live[keep - 1].end(), [](bool b) { return b; })) {
+            --keep;
+            cap -= chunks[keep].count;
         }
+        if (keep == chunks.size()) return;
 
-        buffer     = newBuf;
-        free_list  = newFree;
-        capacity   = newCap;
+        FreeSlot** link = &free_head;
+        while (*link) {
+            if (chunkOf(*link) >= keep) *link = (*link)->next;
+            else link = &(*link)->next;
+        }
+        for (std::size_t c = keep; c < chunks.size(); ++c) {
+            deallocate(chunks[c].slots);
+        }
+        chunks.resize(keep);
+        capacity = cap;
     }
 
     template<typename... TArgs>
     Object acquire(TArgs&&... args) {
-        std::size_t i = 0;
-        while (i < capacity && !free_list[i]) ++i;
-        if (i == capacity) throw std::bad_alloc();
+        if (free_head == nullptr) {
+            if (growth == 0) throw std::bad_alloc();
+            addChunk(growth);
+        }
 
-        free_list[i] = false;
-        char* base  = static_cast<char*>(buffer);
-        TType* ptr  = reinterpret_cast<TType*>(base + i * sizeof(TType));
+        FreeSlot* slot = free_head;
+        free_head = slot->next;
+        TType* ptr = reinterpret_cast<TType*>(slot);
 
         try {
             new (ptr) TType(std::forward<TArgs>(args)...);
         } catch (...) {
-            free_list[i] = true;
+            pushFree(ptr);
             throw;
         }
 
-        return Object(this, i, ptr);
-}
+        return Object(this, ptr);
+    }
 
 private:
-    void*       buffer;
-    bool*       free_list;
-    std::size_t capacity;
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    struct Chunk {
+        char*       slots;
+        std::size_t count;
+    };
+
+    static char* allocate(std::size_t count) {
+        return static_cast<char*>(operator new[](count * slotSize, std::align_val_t(slotAlign)));
+    }
+
+    static void deallocate(char* buf) noexcept {
+        operator delete[](buf, std::align_val_t(slotAlign));
+    }
+
+    static TType* objectAt(char* base, std::size_t i) noexcept {
+        return reinterpret_cast<TType*>(base + i * slotSize);
+    }
+
+    void addChunk(std::size_t count) {
+        char* slots = allocate(count);
+        try {
+            chunks.push_back({slots, count});
+        } catch (...) {
+            deallocate(slots);
+            throw;
+        }
+        for (std::size_t i = count; i-- > 0;) {
+            pushFree(slots + i * slotSize);
+        }
+        capacity += count;
+    }
+
+    void pushFree(void* slot) noexcept {
+        free_head = new (slot) FreeSlot{free_head};
+    }
+
+    void release(TType* ptr) noexcept {
+        ptr->~TType();
+        pushFree(ptr);
+    }
+
+    std::size_t chunkOf(const void* slot) const {
+        const char* p = static_cast<const char*>(slot);
+        for (std::size_t c = 0; c < chunks.size(); ++c) {
+            if (p >= chunks[c].slots && p < chunks[c].slots + chunks[c].count * slotSize)
+                return c;
+        }
+        return chunks.size();
+    }
+
+    // Merge sort of the free list, relinking the slots themselves.
+    static FreeSlot* sortByAddress(FreeSlot* head) noexcept {
+        if (!head || !head->next) return head;
+        FreeSlot* slow = head;
+        for (FreeSlot* fast = head->next; fast && fast->next; fast = fast->next->next) {
+            slow = slow->next;
+        }
+        FreeSlot* second = slow->next;
+        slow->next = nullptr;
+        FreeSlot* a = sortByAddress(head);
+        FreeSlot* b = sortByAddress(second);
+
+        FreeSlot* merged = nullptr;
+        FreeSlot** tail = &merged;
+        while (a && b) {
+            FreeSlot*& lower = std::less<FreeSlot*>()(a, b) ? a : b;
+            *tail = lower;
+            tail = &lower->next;
+            lower = lower->next;
+        }
+        *tail = a ? a : b;
+        return merged;
+    }
+
+    std::vector<std::vector<bool>> liveSlots() const {
+        std::vector<std::vector<bool>> live(chunks.size());
+        std::vector<std::size_t> byAddress(chunks.size());
+        for (std::size_t c = 0; c < chunks.size(); ++c) {
+            live[c].assign(chunks[c].count, true);
+            byAddress[c] = c;
+        }
+        std::sort(byAddress.begin(), byAddress.end(), [this](std::size_t a, std::size_t b) {
+            return chunks[a].slots < chunks[b].slots;
+        });
+
+        for (FreeSlot* s = free_head; s; s = s->next) {
+            const char* p = reinterpret_cast<const char*>(s);
+            auto it = std::upper_bound(byAddress.begin(), byAddress.end(), p,
+                [this](const char* addr, std::size_t c) { return addr < chunks[c].slots; });
+            std::size_t c = *(it - 1);
+            live[c][(p - chunks[c].slots) / slotSize] = false;
+        }
+        return live;
+    }
+
+    std::vector<Chunk> chunks;
+    FreeSlot*          free_head;
+    std::size_t        capacity;
+    std::size_t        growth;
 };
 
-template<typename TType>
-class Pool<TType>::Object {
+template<typename TType, bool TCacheAligned>
+class Pool<TType, TCacheAligned>::Object {
 public:
     Object(Object&& other) noexcept
-        : pool(other.pool), index(other.index), ptr(other.ptr), released(other.released) {
+        : pool(other.pool), ptr(other.ptr), released(other.released) {
         other.released = true;
     }
 
     ~Object() noexcept {
         if (!released) {
-            ptr->~TType();
-            pool->free_list[index] = true;
+            pool->release(ptr);
             released = true;
         }
     }
 
     TType* operator->() { return ptr; }
+    TType& operator*() { return *ptr; }
 
 private:
     friend Pool;
-    Object(Pool* p, std::size_t idx, TType* pPtr) noexcept
-        : pool(p), index(idx), ptr(pPtr), released(false) {}
+    Object(Pool* p, TType* pPtr) noexcept
+        : pool(p), ptr(pPtr), released(false) {}
 
-    Pool<TType>*    pool;
-    std::size_t     index;
-    TType*          ptr;
-    bool            released;
+    Pool*   pool;
+    TType*  ptr;
+    bool    released;
 };
-
-
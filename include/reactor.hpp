@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#ifdef __linux__
+# include <sys/epoll.h>
+#endif
+
+class Reactor {
+public:
+    enum Interest : uint32_t {
+        Read  = 1 << 0,
+        Write = 1 << 1,
+        Error = 1 << 2
+    };
+
+    struct Event {
+        int      fd;
+        uint32_t events;
+    };
+
+    virtual ~Reactor(void) = default;
+
+    virtual void add(int fd, uint32_t interest) = 0;
+    virtual void modify(int fd, uint32_t interest) = 0;
+    virtual void remove(int fd) = 0;
+
+    // Fills `events` with ready fds, returns 0 when interrupted by a signal.
+    virtual std::size_t wait(std::vector<Event>& events, int timeoutMs) = 0;
+
+    // Edge-triggered backends only report transitions, so callers must
+    // drain reads, accepts and writes until EAGAIN.
+    virtual bool edgeTriggered(void) const = 0;
+};
+
+class PollReactor : public Reactor {
+public:
+    void add(int fd, uint32_t interest) override {
+        if (static_cast<std::size_t>(fd) >= slots_.size())
+            slots_.resize(static_cast<std::size_t>(fd) + 1, -1);
+        if (slots_[fd] >= 0)
+            throw std::logic_error("fd already registered");
+        slots_[fd] = static_cast<int>(fds_.size());
+        fds_.push_back({fd, toPoll(interest), 0});
+    }
+
+    void modify(int fd, uint32_t interest) override {
+        fds_[slotOf(fd)].events = toPoll(interest);
+    }
+
+    void remove(int fd) override {
+        int slot = slotOf(fd);
+        int last = static_cast<int>(fds_.size()) - 1;
+        if (slot != last) {
+            fds_[slot] = fds_[last];
+            slots_[fds_[slot].fd] = slot;
+        }
+        fds_.pop_back();
+        slots_[fd] = -1;
+    }
+
+    std::size_t wait(std::vector<Event>& events, int timeoutMs) override {
+        events.clear();
+        int ready = ::poll(fds_.data(), static_cast<nfds_t>(fds_.size()), timeoutMs);
+        if (ready < 0) {
+            if (errno == EINTR) return 0;
+            throw std::runtime_error("poll failed: " + std::string(std::strerror(errno)));
+        }
+        for (std::size_t i = 0; i < fds_.size() && ready > 0; ++i) {
+            short re = fds_[i].revents;
+            if (re == 0) continue;
+            --ready;
+            uint32_t ev = 0;
+            if (re & POLLIN)                      ev |= Read;
+            if (re & POLLOUT)                     ev |= Write;
+            if (re & (POLLHUP | POLLERR | POLLNVAL)) ev |= Error;
+            events.push_back({fds_[i].fd, ev});
+        }
+        return events.size();
+    }
+
+    bool edgeTriggered(void) const override { return false; }
+
+private:
+    static short toPoll(uint32_t interest) {
+        short ev = 0;
+        if (interest & Read)  ev |= POLLIN;
+        if (interest & Write) ev |= POLLOUT;
+        return ev;
+    }
+
+    int slotOf(int fd) const {
+        if (fd < 0 || static_cast<std::size_t>(fd) >= slots_.size() || slots_[fd] < 0)
+            throw std::logic_error("fd not registered");
+        return slots_[fd];
+    }
+
+    std::vector<pollfd> fds_;
+    std::vector<int>    slots_;
+};
+
+#ifdef __linux__
+class EpollReactor : public Reactor {
+public:
+    EpollReactor(void) : epfd_(::epoll_create1(EPOLL_CLOEXEC)) {
+        if (epfd_ < 0)
+            throw std::runtime_error("epoll_create1 failed: " + std::string(std::strerror(errno)));
+    }
+
+    ~EpollReactor(void) override {
+        ::close(epfd_);
+    }
+
+    EpollReactor(const EpollReactor&) = delete;
+    EpollReactor& operator=(const EpollReactor&) = delete;
+
+    void add(int fd, uint32_t interest) override {
+        control(EPOLL_CTL_ADD, fd, interest);
+        ++registered_;
+    }
+
+    void modify(int fd, uint32_t interest) override {
+        control(EPOLL_CTL_MOD, fd, interest);
+    }
+
+    void remove(int fd) override {
+        control(EPOLL_CTL_DEL, fd, 0);
+        --registered_;
+    }
+
+    std::size_t wait(std::vector<Event>& events, int timeoutMs) override {
+        events.clear();
+        ready_.resize(std::min<std::size_t>(std::max<std::size_t>(registered_, 1), maxEvents));
+        int n = ::epoll_wait(epfd_, ready_.data(), static_cast<int>(ready_.size()), timeoutMs);
+        if (n < 0) {
+            if (errno == EINTR) return 0;
+            throw std::runtime_error("epoll_wait failed: " + std::string(std::strerror(errno)));
+        }
+        for (int i = 0; i < n; ++i) {
+            uint32_t re = ready_[i].events;
+            uint32_t ev = 0;
+            if (re & EPOLLIN)                          ev |= Read;
+            if (re & EPOLLOUT)                         ev |= Write;
+            if (re & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) ev |= Error;
+            events.push_back({ready_[i].data.fd, ev});
+        }
+        return events.size();
+    }
+
+    bool edgeTriggered(void) const override { return true; }
+
+private:
+    void control(int op, int fd, uint32_t interest) {
+        epoll_event ev{};
+        ev.events = EPOLLET | EPOLLRDHUP;
+        if (interest & Read)  ev.events |= EPOLLIN;
+        if (interest & Write) ev.events |= EPOLLOUT;
+        ev.data.fd = fd;
+        if (::epoll_ctl(epfd_, op, fd, &ev) < 0)
+            throw std::runtime_error("epoll_ctl failed: " + std::string(std::strerror(errno)));
+    }
+
+    static constexpr std::size_t maxEvents = 1024;
+
+    int                      epfd_;
+    std::size_t              registered_{0};
+    std::vector<epoll_event> ready_;
+};
+#endif
+
+inline std::unique_ptr<Reactor> makeDefaultReactor(void) {
+#ifdef __linux__
+    return std::make_unique<EpollReactor>();
+#else
+    return std::make_unique<PollReactor>();
+#endif
+}
@@ -1,194 +1,436 @@
 #pragma once
 
 #include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
 #include <functional>
 #include <netinet/in.h>
-#include <poll.h>
 #include <stdexcept>
 #include <sys/socket.h>
 #include <fcntl.h>
+#include <atomic>
 #include <map>
+#include <memory>
 #include <unistd.h>
 
 #include "message.hpp"
+#include "reactor.hpp"
+#include "mpsc_queue.hpp"
+#include "timer_wheel.hpp"
 
 class Server {
-    std::vector<pollfd> pollFds_;
+    struct Connection {
+        bool                    open = false;
+        bool                    failed = false;     // send error, closed at the end of update()
+        uint32_t                generation = 0;     // bumped each time the fd gets a new client
+        std::size_t             index = 0;
+        std::vector<uint8_t>    pending;
+        std::size_t             pendingOffset = 0;
+        std::vector<uint8_t>    inbox;
+        std::size_t             inboxStart = 0;
+        std::size_t             inboxEnd = 0;
+    };
+
+    static constexpr std::size_t readChunk = 16 * 1024;
+    static constexpr std::size_t defaultMaxFrameSize = 16 * 1024 * 1024;
+
+    std::unique_ptr<Reactor> reactor_;
+    std::vector<Reactor::Event> events_;
+    int listenFd_ = -1;
+    std::vector<Connection> connections_;
+    std::vector<int> clients_;
+    std::vector<int> failed_;
     std::map<Message::Type, std::function<void(long long&, const Message&)>> actions_;
-    std::map<int, std::vector<uint8_t>> pending_;
+    int wakeFds_[2] = {-1, -1};
+    std::atomic<bool> wakePending_{false};
+    MpscQueue<std::function<void()>> mailbox_;
+    TimerWheel timers_;
+    std::size_t maxFrameSize_ = defaultMaxFrameSize;
 public:
-    void start(const std::size_t& p_port) {
-        pollfd serverFd = {::socket(AF_INET, SOCK_STREAM, 0), POLLIN, 0};
-        if (serverFd.fd < 0) {
+    explicit Server(std::unique_ptr<Reactor> reactor = makeDefaultReactor())
+        : reactor_(std::move(reactor)) {
+        if (::pipe(wakeFds_) < 0) {
+            throw std::runtime_error("pipe failed");
+        }
+        for (int fd : wakeFds_) {
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        }
+        reactor_->add(wakeFds_[0], Reactor::Read);
+    }
+
+    ~Server(void) {
+        stop();
+        ::close(wakeFds_[0]);
+        ::close(wakeFds_[1]);
+    }
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // reusePort lets several servers in the same process listen on one port,
+    // the kernel then spreads incoming connections between them.
+    void start(const std::size_t& p_port, bool reusePort = false) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
             throw std::runtime_error("Socket creation failed");
         }
 
         int yes = 1;
-        setsockopt(serverFd.fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (reusePort && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes)) < 0) {
+            ::close(fd);
+            throw std::runtime_error("SO_REUSEPORT failed");
+        }
 
         sockaddr_in addr{};
         addr.sin_family = AF_INET;
         addr.sin_port = htons(static_cast<uint16_t>(p_port));
         addr.sin_addr.s_addr = INADDR_ANY;
-        if (bind(serverFd.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd);
             throw std::runtime_error("Bind failed");
         }
 
-        if (listen(serverFd.fd, SOMAXCONN) < 0) {
+        if (listen(fd, SOMAXCONN) < 0) {
+            ::close(fd);
             throw std::runtime_error("Listen failed");
         }
 
-        int flags = fcntl(serverFd.fd, F_GETFL, 0);
+        int flags = fcntl(fd, F_GETFL, 0);
         if (flags < 0) {
+            ::close(fd);
             throw std::runtime_error("fcntl F_GETFL failed");
         }
-        if (fcntl(serverFd.fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            ::close(fd);
             throw std::runtime_error("fcntl F_SETFL failed");
         }
 
-        pollFds_.push_back(serverFd);
+        reactor_->add(fd, Reactor::Read);
+        listenFd_ = fd;
+    }
+
+    // Stops listening and disconnects every client. Tasks posted and not
+    // yet run are dropped. Call it from the thread running update().
+    void stop(void) {
+        while (!clients_.empty()) {
+            disconnect(clients_.back());
+        }
+        if (listenFd_ >= 0) {
+            reactor_->remove(listenFd_);
+            ::close(listenFd_);
+            listenFd_ = -1;
+        }
+        while (mailbox_.try_pop()) {}
     }
 
     void defineAction(const Message::Type& messageType, const std::function<void(long long& clientID, const Message& msg)>& action) {
         actions_[messageType] = action;
     }
 
+    // Largest frame (header included) a client may send; a client
+    // announcing a bigger one is disconnected. Defaults to 16 MiB.
+    void setMaxFrameSize(std::size_t bytes) {
+        maxFrameSize_ = bytes;
+    }
+
     void sendTo(const Message& message, long long clientID) {
         send(static_cast<int>(clientID), message);
     }
 
+    // Tells apart successive clients on the same fd, 0 if no client has it.
+    uint32_t generation(long long clientID) const {
+        int fd = static_cast<int>(clientID);
+        return isOpen(fd) ? connections_[fd].generation : 0;
+    }
+
     void sendToArray(const Message& message, std::vector<long long> clientIDs) {
         for (const auto& id : clientIDs) {
             send(static_cast<int>(id), message);
         }
     }
 
+    // Backwards, a client failing on send is only removed later but the
+    // order must not matter.
     void sendToAll(const Message& message) {
-        for (const auto& [fd, events, revents] : pollFds_) {
-            if (fd == pollFds_[0].fd) continue;
-            send(static_cast<int>(fd), message);
+        for (std::size_t i = clients_.size(); i-- > 0;) {
+            send(clients_[i], message);
         }
     }
 
+    // Runs `task` on the thread calling update(). Safe from any thread, and
+    // wakes an update() blocked in its wait.
+    void post(std::function<void()> task) {
+        mailbox_.push(std::move(task));
+        if (!wakePending_.exchange(true, std::memory_order_acq_rel)) {
+            char byte = 1;
+            while (::write(wakeFds_[1], &byte, 1) < 0 && errno == EINTR) {}
+        }
+    }
+
+    // Runs callback on the loop thread once delay has elapsed. Timers must
+    // be added and cancelled from the loop thread, use post() elsewhere.
+    TimerWheel::TimerId addTimer(std::chrono::milliseconds delay, std::function<void()> callback) {
+        return timers_.schedule(delay, std::move(callback));
+    }
+
+    bool cancelTimer(TimerWheel::TimerId id) {
+        return timers_.cancel(id);
+    }
+
     void update(void) {
-        int nfds = static_cast<int>(pollFds_.size());
-        int ready = ::poll(pollFds_.data(), nfds, 0);
-        if (ready < 0) {
-            if (errno == EINTR) return;
-            throw std::runtime_error("poll failed: " + std::string(std::strerror(errno)));
-        }
-
-        for (int i = 0; i < nfds; ++i) {
-            auto &pfd = pollFds_[i];
-            int fd = pfd.fd;
-            short re = pfd.revents;
-            if (re == 0) continue;
-
-            if (fd == pollFds_[0].fd && (re & POLLIN)) {
-                int clientFd = ::accept(fd, nullptr, nullptr);
-                if (clientFd >= 0) {
-                    int flags = ::fcntl(clientFd, F_GETFL, 0);
-                    ::fcntl(clientFd, F_SETFL, flags | O_NONBLOCK);
-                    pollFds_.push_back({clientFd, POLLIN, 0});
-                }
-                continue;
+        update(0);
+    }
+
+    // Waits up to timeoutMs for activity, -1 blocks until something happens.
+    // The wait is cut short by the next timer deadline. Every ready client
+    // and posted task is handled even if an action or task throws; the first
+    // exception is rethrown once they all ran. A client whose socket fails
+    // (EPIPE, ECONNRESET...) is disconnected.
+    void update(int timeoutMs) {
+        int timerMs = timers_.timeoutMs(TimerWheel::Clock::now());
+        if (timerMs >= 0 && (timeoutMs < 0 || timerMs < timeoutMs)) {
+            timeoutMs = timerMs;
+        }
+        reactor_->wait(events_, mailbox_.empty() ? timeoutMs : 0);
+        timers_.advance(TimerWheel::Clock::now());
+
+        std::exception_ptr error;
+        for (const auto& [fd, ev] : events_) {
+            try {
+                handleEvent(fd, ev);
+            } catch (...) {
+                if (!error) error = std::current_exception();
             }
+        }
 
-            if (re & (POLLHUP | POLLERR)) {
-                ::close(fd);
-                pollFds_.erase(pollFds_.begin() + i);
-                --i; --nfds;
-                continue;
+        runPosted(error);
+        disconnectFailed();
+        if (error) std::rethrow_exception(error);
+    }
+
+private:
+    void handleEvent(int fd, uint32_t ev) {
+        if (fd == wakeFds_[0]) {
+            char drain[64];
+            while (::read(fd, drain, sizeof(drain)) > 0) {}
+            return;
+        }
+
+        if (fd == listenFd_) {
+            acceptClients();
+            return;
+        }
+
+        if ((ev & Reactor::Write) && isLive(fd)) {
+            flush(fd);
+        }
+
+        if ((ev & Reactor::Read) && isLive(fd)) {
+            if (!receive(fd)) {
+                disconnect(fd);
+                return;
+            }
+        }
+
+        if ((ev & Reactor::Error) && isOpen(fd)) {
+            disconnect(fd);
+        }
+    }
+
+    void runPosted(std::exception_ptr& error) {
+        wakePending_.exchange(false, std::memory_order_acq_rel);
+        while (auto task = mailbox_.try_pop()) {
+            try {
+                (*task)();
+            } catch (...) {
+                if (!error) error = std::current_exception();
             }
+        }
+    }
+
+    bool isOpen(int fd) const {
+        return fd >= 0 && static_cast<std::size_t>(fd) < connections_.size()
+            && connections_[fd].open;
+    }
+
+    bool isLive(int fd) const {
+        return isOpen(fd) && !connections_[fd].failed;
+    }
+
+    // Closing right away could free the inbox a dispatch is reading from.
+    void fail(int fd) {
+        Connection& conn = connections_[fd];
+        if (conn.failed) return;
+        conn.failed = true;
+        failed_.push_back(fd);
+    }
+
+    void disconnectFailed(void) {
+        for (int fd : failed_) {
+            if (isOpen(fd) && connections_[fd].failed) disconnect(fd);
+        }
+        failed_.clear();
+    }
 
-            if (re & POLLOUT) {
-                auto itp = pending_.find(fd);
-                if (itp != pending_.end()) {
-                    const uint8_t* ptr = itp->second.data();
-                    size_t left = itp->second.size();
-                    ssize_t sent = ::send(fd, ptr, left, 0);
-                    if (sent > 0) {
-                        itp->second.erase(itp->second.begin(), itp->second.begin() + sent);
-                    } else if (sent < 0 && errno != EAGAIN && errno != EINTR) {
-                        throw std::runtime_error("send pending failed");
-                    }
-                    if (itp->second.empty()) {
-                        pending_.erase(itp);
-                        pfd.events &= ~POLLOUT;
-                    }
-                }
+    void acceptClients(void) {
+        while (true) {
+            int clientFd = ::accept(listenFd_, nullptr, nullptr);
+            if (clientFd < 0) {
+                if (errno == EINTR) continue;
+                return;
             }
+            int flags = ::fcntl(clientFd, F_GETFL, 0);
+            ::fcntl(clientFd, F_SETFL, flags | O_NONBLOCK);
 
-            if (re & POLLIN) {
-                uint32_t hdr[2];
-                ssize_t r = ::recv(fd, hdr, sizeof(hdr), MSG_PEEK);
-                if (r <= 0) continue;
-                uint32_t type   = ntohl(hdr[0]);
-                uint32_t length = ntohl(hdr[1]);
-                std::vector<uint8_t> buffer(sizeof(hdr) + length);
-                r = ::recv(fd, buffer.data(), buffer.size(), MSG_WAITALL);
-                if (r <= 0) continue;
-                Message msg = Message::fromRaw(buffer);
-                auto it = actions_.find(type);
-                if (it != actions_.end()) {
-                    long long clientID = static_cast<long long>(fd);
-                    it->second(clientID, msg);
-                }
+            if (static_cast<std::size_t>(clientFd) >= connections_.size()) {
+                connections_.resize(static_cast<std::size_t>(clientFd) + 1);
             }
+            Connection& conn = connections_[clientFd];
+            conn.open = true;
+            ++conn.generation;
+            conn.index = clients_.size();
+            clients_.push_back(clientFd);
+            reactor_->add(clientFd, Reactor::Read);
+
+            if (!reactor_->edgeTriggered()) return;
         }
     }
 
-private:
-    void subscribeWrite(int fd) {
-        for (auto &pfd : pollFds_) {
-            if (pfd.fd == fd) {
-                pfd.events |= POLLOUT;
-                break;
+    void disconnect(int fd) {
+        Connection& conn = connections_[fd];
+        int last = clients_.back();
+        clients_[conn.index] = last;
+        connections_[last].index = conn.index;
+        clients_.pop_back();
+
+        reactor_->remove(fd);
+        ::close(fd);
+        uint32_t generation = conn.generation;
+        conn = Connection();
+        conn.generation = generation;
+    }
+
+    // Reads what is available into the client's inbox and dispatches every
+    // complete frame in place. Returns false once the peer is gone.
+    bool receive(int fd) {
+        Connection& conn = connections_[fd];
+        while (true) {
+            reserveInbox(conn, readChunk);
+            std::size_t room = conn.inbox.size() - conn.inboxEnd;
+            ssize_t r = ::recv(fd, conn.inbox.data() + conn.inboxEnd, room, 0);
+            if (r == 0) return false;
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
             }
+            conn.inboxEnd += static_cast<std::size_t>(r);
+
+            dispatchFrames(fd, conn);
+            if (!isLive(fd)) return true;
+            if (!reactor_->edgeTriggered()) return true;
         }
     }
 
-    void unsubscribeWrite(int fd) {
-        for (auto &pfd : pollFds_) {
-            if (pfd.fd == fd) {
-                pfd.events &= ~POLLOUT;
-                break;
+    void dispatchFrames(int fd, Connection& conn) {
+        while (conn.inboxEnd - conn.inboxStart >= Message::headerSize) {
+            const uint8_t* frame = conn.inbox.data() + conn.inboxStart;
+            std::size_t available = conn.inboxEnd - conn.inboxStart;
+            uint32_t type   = Message::readUInt32BE(frame);
+            uint32_t length = Message::readUInt32BE(frame + 4);
+            std::size_t frameSize = Message::headerSize + length;
+
+            if (frameSize > maxFrameSize_) {
+                disconnect(fd);
+                return;
             }
+            if (available < frameSize) {
+                reserveInbox(conn, frameSize - available);
+                return;
+            }
+
+            // Parsed in place: the action reads from the inbox, a copy of
+            // the message owns its payload.
+            Message msg = Message::viewRaw(frame, frameSize);
+            conn.inboxStart += frameSize;
+            if (conn.failed) continue;
+
+            auto it = actions_.find(type);
+            if (it != actions_.end()) {
+                long long clientID = static_cast<long long>(fd);
+                it->second(clientID, msg);
+            }
+        }
+        if (conn.inboxStart == conn.inboxEnd) {
+            conn.inboxStart = conn.inboxEnd = 0;
         }
     }
 
+    // Makes room for `needed` bytes after inboxEnd. Only the unparsed tail
+    // is ever moved, and only when the free space at the end runs out.
+    static void reserveInbox(Connection& conn, std::size_t needed) {
+        if (conn.inbox.size() - conn.inboxEnd >= needed) return;
+        if (conn.inboxStart > 0) {
+            std::memmove(conn.inbox.data(), conn.inbox.data() + conn.inboxStart,
+                         conn.inboxEnd - conn.inboxStart);
+            conn.inboxEnd  -= conn.inboxStart;
+            conn.inboxStart = 0;
+        }
+        if (conn.inbox.size() - conn.inboxEnd < needed) {
+            conn.inbox.resize(conn.inboxEnd + needed);
+        }
+    }
+
+    void flush(int fd) {
+        Connection& conn = connections_[fd];
+        while (conn.pendingOffset < conn.pending.size()) {
+            const uint8_t* ptr = conn.pending.data() + conn.pendingOffset;
+            std::size_t left = conn.pending.size() - conn.pendingOffset;
+            ssize_t sent = ::send(fd, ptr, left, Message::sendFlags);
+            if (sent > 0) {
+                conn.pendingOffset += static_cast<std::size_t>(sent);
+                continue;
+            }
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                fail(fd);
+            }
+            return;
+        }
+        conn.pending.clear();
+        conn.pendingOffset = 0;
+        reactor_->modify(fd, Reactor::Read);
+    }
+
     void send(int fd, const Message& message) {
-        std::vector<uint8_t> buf;
-        auto pit = pending_.find(fd);
-        if (pit != pending_.end()) {
-            buf = std::move(pit->second);
-            pending_.erase(pit);
-        }
-        auto raw = message.raw();
-        buf.insert(buf.end(), raw.begin(), raw.end());
-
-        const uint8_t* ptr = buf.data();
-        std::size_t left = buf.size();
-
-        while (left > 0) {
-            ssize_t n = ::send(fd, ptr, left, 0);
-            if (n > 0) {
-                ptr  += n;
-                left -= n;
+        if (!isOpen(fd)) {
+            throw std::runtime_error("send() to unknown client");
+        }
+        Connection& conn = connections_[fd];
+        if (conn.failed) return;
+        Message::Frame frame = message.frame();
+
+        if (!conn.pending.empty()) {
+            frame.appendRemaining(conn.pending);
+            return;
+        }
+
+        while (!frame.done()) {
+            ssize_t n = frame.writeTo(fd);
+            if (n >= 0) {
+                continue;
+            }
+            if (errno == EINTR) {
                 continue;
             }
-            if (n < 0) {
-                if (errno == EINTR) {
-                    continue;
-                }
-                if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    pending_[fd].assign(ptr, ptr + left);
-                    subscribeWrite(fd);
-                    return;
-                }
-                throw std::runtime_error(std::string{"send() failed: "} + std::strerror(errno));
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                frame.appendRemaining(conn.pending);
+                reactor_->modify(fd, Reactor::Read | Reactor::Write);
+                return;
             }
+            fail(fd);
+            return;
         }
-        unsubscribeWrite(fd);
     }
 };
\ No newline at end of file
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "server.hpp"
+
+// N Server event loops, each on its own thread with its own SO_REUSEPORT
+// listening socket. Client IDs carry the owning loop and the fd's generation
+// in their high 32 bits, so sendTo() can route a message to that loop's
+// mailbox without a lookup, and a message meant for a client that left is
+// not delivered to the next one given the same fd. A loop that gives up
+// closes its listener and drops its clients; sendTo() then rejects them.
+// Actions run on the loop thread owning the client and must be thread-safe.
+class ShardedServer {
+public:
+    // Called on the shard's thread for every error its loop catches, stopped
+    // telling whether the shard gave up and left its loop.
+    using ErrorHandler = std::function<void(std::size_t shard, const std::exception& error, bool stopped)>;
+
+private:
+    // A shard failing this many updates in a row is considered wedged.
+    static constexpr int maxConsecutiveErrors = 16;
+
+    // Client ID: shard (11 bits) | generation (20 bits) | fd (32 bits).
+    static constexpr int generationShift = 32;
+    static constexpr int shardShift = 52;
+    static constexpr uint32_t generationMask = (1u << (shardShift - generationShift)) - 1;
+    static constexpr std::size_t maxShards = std::size_t(1) << (63 - shardShift);
+
+    std::vector<std::unique_ptr<Server>> shards_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> running_{false};
+    std::unique_ptr<std::atomic<bool>[]> stopped_;
+    ErrorHandler onError_ = [](std::size_t shard, const std::exception& error, bool stopped) {
+        std::cerr << "shard " << shard << (stopped ? " stopped: " : ": ") << error.what() << std::endl;
+    };
+
+    inline static thread_local const ShardedServer* currentOwner_ = nullptr;
+    inline static thread_local std::size_t currentShard_ = 0;
+
+    static long long makeID(std::size_t shard, uint32_t generation, long long fd) {
+        return static_cast<long long>(shard) << shardShift
+            | static_cast<long long>(generation & generationMask) << generationShift | fd;
+    }
+
+    static std::size_t shardOf(long long clientID) {
+        return static_cast<std::size_t>(clientID >> shardShift);
+    }
+
+    static uint32_t generationOf(long long clientID) {
+        return static_cast<uint32_t>(clientID >> generationShift) & generationMask;
+    }
+
+    static long long fdOf(long long clientID) {
+        return clientID & 0xFFFFFFFFLL;
+    }
+
+    // On the shard's thread: false once the client that had this ID left.
+    static bool isCurrent(const Server& server, long long clientID) {
+        uint32_t generation = server.generation(fdOf(clientID));
+        return generation != 0 && (generation & generationMask) == generationOf(clientID);
+    }
+
+    bool onShard(std::size_t shard) const {
+        return currentOwner_ == this && currentShard_ == shard;
+    }
+
+    void loop(std::size_t shard) {
+        currentOwner_ = this;
+        currentShard_ = shard;
+        int failures = 0;
+        bool gaveUp = false;
+        while (!gaveUp && running_.load(std::memory_order_acquire)) {
+            try {
+                shards_[shard]->update(-1);
+                failures = 0;
+            } catch (const std::bad_alloc& e) {
+                gaveUp = true;
+                report(shard, e, true);
+            } catch (const std::logic_error& e) {
+                gaveUp = true;
+                report(shard, e, true);
+            } catch (const std::exception& e) {
+                gaveUp = ++failures >= maxConsecutiveErrors;
+                report(shard, e, gaveUp);
+            } catch (...) {
+                gaveUp = true;
+                report(shard, std::runtime_error("unknown exception"), true);
+            }
+        }
+        if (!gaveUp) return;
+
+        // Nobody accepts on this listener or drains this mailbox any more.
+        stopped_[shard].store(true, std::memory_order_release);
+        try {
+            shards_[shard]->stop();
+        } catch (const std::exception& e) {
+            report(shard, e, true);
+        }
+    }
+
+    void report(std::size_t shard, const std::exception& error, bool stopped) const {
+        if (!onError_) return;
+        try {
+            onError_(shard, error, stopped);
+        } catch (...) {}
+    }
+
+public:
+    explicit ShardedServer(std::size_t numLoops = std::thread::hardware_concurrency()) {
+        if (numLoops == 0) numLoops = 1;
+        if (numLoops > maxShards) {
+            throw std::invalid_argument("too many loops");
+        }
+        stopped_ = std::make_unique<std::atomic<bool>[]>(numLoops);
+        for (std::size_t i = 0; i < numLoops; ++i) {
+            shards_.push_back(std::make_unique<Server>());
+        }
+    }
+
+    ~ShardedServer(void) {
+        stop();
+    }
+
+    ShardedServer(const ShardedServer&) = delete;
+    ShardedServer& operator=(const ShardedServer&) = delete;
+
+    std::size_t loops(void) const { return shards_.size(); }
+
+    // Must be called before start().
+    void defineAction(const Message::Type& messageType, const std::function<void(long long& clientID, const Message& msg)>& action) {
+        for (std::size_t shard = 0; shard < shards_.size(); ++shard) {
+            Server* server = shards_[shard].get();
+            shards_[shard]->defineAction(messageType, [shard, server, action](long long& fd, const Message& msg) {
+                long long clientID = makeID(shard, server->generation(fd), fd);
+                action(clientID, msg);
+            });
+        }
+    }
+
+    // Must be called before start(), see Server::setMaxFrameSize().
+    void setMaxFrameSize(std::size_t bytes) {
+        for (auto& shard : shards_) {
+            shard->setMaxFrameSize(bytes);
+        }
+    }
+
+    // Must be called before start(). Errors thrown by the handler itself are
+    // dropped. By default errors are written to std::cerr.
+    void setErrorHandler(ErrorHandler handler) {
+        onError_ = std::move(handler);
+    }
+
+    void start(const std::size_t& p_port) {
+        for (auto& shard : shards_) {
+            shard->start(p_port, shards_.size() > 1);
+        }
+        running_.store(true, std::memory_order_release);
+        for (std::size_t shard = 0; shard < shards_.size(); ++shard) {
+            threads_.emplace_back(&ShardedServer::loop, this, shard);
+        }
+    }
+
+    void stop(void) {
+        if (!running_.exchange(false, std::memory_order_acq_rel)) return;
+        for (auto& shard : shards_) {
+            shard->post([] {});
+        }
+        for (auto& t : threads_) {
+            if (t.joinable()) t.join();
+        }
+        threads_.clear();
+    }
+
+    // A message for a client that has left is dropped.
+    void sendTo(const Message& message, long long clientID) {
+        std::size_t shard = shardOf(clientID);
+        if (shard >= shards_.size()) {
+            throw std::invalid_argument("unknown client");
+        }
+        if (stopped_[shard].load(std::memory_order_acquire)) {
+            throw std::runtime_error("client's loop has stopped");
+        }
+        Server* server = shards_[shard].get();
+        if (onShard(shard)) {
+            if (isCurrent(*server, clientID)) server->sendTo(message, fdOf(clientID));
+            return;
+        }
+        server->post([this, shard, server, message, clientID] {
+            if (!isCurrent(*server, clientID)) return;
+            try {
+                server->sendTo(message, fdOf(clientID));
+            } catch (const std::exception& e) {
+                report(shard, e, false);
+            }
+        });
+    }
+
+    void sendToArray(const Message& message, std::vector<long long> clientIDs) {
+        for (const auto& id : clientIDs) {
+            sendTo(message, id);
+        }
+    }
+
+    void sendToAll(const Message& message) {
+        for (std::size_t shard = 0; shard < shards_.size(); ++shard) {
+            if (stopped_[shard].load(std::memory_order_acquire)) continue;
+            if (onShard(shard)) {
+                shards_[shard]->sendToAll(message);
+                continue;
+            }
+            Server* server = shards_[shard].get();
+            server->post([this, shard, server, message] {
+                try {
+                    server->sendToAll(message);
+                } catch (const std::exception& e) {
+                    report(shard, e, false);
+                }
+            });
+        }
+    }
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+// Fast LZ77 byte codec in the style of an LZ4 block: a sequence is a token
+// (literal count in the high nibble, match length - 4 in the low nibble,
+// 15 meaning "more length bytes follow"), the literals, then a 2-byte
+// little-endian back offset into the last 64 KiB. The last sequence has no
+// match. The stream starts with the decoded size as a varint.
+class SnapshotCodec {
+public:
+    static void compress(const uint8_t* src, std::size_t size, std::vector<uint8_t>& out) {
+        out.clear();
+        out.reserve(size / 2 + 16);
+        putVarint(out, size);
+
+        uint32_t table[hashSize];
+        std::memset(table, 0xFF, sizeof(table));
+
+        std::size_t anchor = 0;
+        std::size_t pos = 0;
+        while (pos + minMatch <= size) {
+            uint32_t h = hash(src + pos);
+            std::size_t candidate = table[h];
+            table[h] = static_cast<uint32_t>(pos);
+            if (candidate == empty || pos - candidate > maxOffset
+                || std::memcmp(src + candidate, src + pos, minMatch) != 0) {
+                ++pos;
+                continue;
+            }
+
+            std::size_t length = minMatch;
+            while (pos + length < size && src[candidate + length] == src[pos + length]) ++length;
+
+            putSequence(out, src + anchor, pos - anchor, length - minMatch);
+            uint16_t offset = static_cast<uint16_t>(pos - candidate);
+            out.push_back(static_cast<uint8_t>(offset));
+            out.push_back(static_cast<uint8_t>(offset >> 8));
+            putLength(out, length - minMatch);
+
+            pos += length;
+            anchor = pos;
+        }
+        putSequence(out, src + anchor, size - anchor, 0);
+    }
+
+    static void decompress(const uint8_t* src, std::size_t size, std::vector<uint8_t>& out) {
+        std::size_t pos = 0;
+        uint64_t expected = getVarint(src, size, pos);
+        // One input byte expands to at most about 255, so a larger size is
+        // corrupt and must not turn into a huge allocation.
+        if (expected > static_cast<uint64_t>(size) * 256) corrupt();
+        out.resize(expected);
+        uint8_t* dst = out.data();
+        std::size_t written = 0;
+        while (pos < size) {
+            uint8_t token = src[pos++];
+            std::size_t literals = getLength(src, size, pos, token >> 4);
+            if (literals > size - pos || literals > expected - written) corrupt();
+            if (literals) std::memcpy(dst + written, src + pos, literals);
+            written += literals;
+            pos += literals;
+            if (pos == size) break;
+
+            if (size - pos < 2) corrupt();
+            std::size_t offset = src[pos] | (static_cast<std::size_t>(src[pos + 1]) << 8);
+            pos += 2;
+            std::size_t length = getLength(src, size, pos, token & 0x0F) + minMatch;
+            if (offset == 0 || offset > written || length > expected - written) corrupt();
+            uint8_t* from = dst + written - offset;
+            if (offset >= length) {
+                std::memcpy(dst + written, from, length);
+            } else {
+                // Overlapping match repeats the bytes it is producing.
+                for (std::size_t i = 0; i < length; ++i) dst[written + i] = from[i];
+            }
+            written += length;
+        }
+        if (written != expected) corrupt();
+    }
+
+private:
+    static constexpr std::size_t minMatch = 4;
+    static constexpr std::size_t maxOffset = 0xFFFF;
+    static constexpr int hashBits = 12;
+    static constexpr std::size_t hashSize = std::size_t(1) << hashBits;
+    static constexpr uint32_t empty = 0xFFFFFFFFu;
+
+    [[noreturn]] static void corrupt(void) {
+        throw std::runtime_error("corrupt compressed snapshot");
+    }
+
+    static uint32_t hash(const uint8_t* p) {
+        uint32_t word;
+        std::memcpy(&word, p, sizeof(word));
+        return (word * 2654435761u) >> (32 - hashBits);
+    }
+
+    static void putLength(std::vector<uint8_t>& out, std::size_t length) {
+        if (length < 15) return;
+        length -= 15;
+        while (length >= 255) {
+            out.push_back(255);
+            length -= 255;
+        }
+        out.push_back(static_cast<uint8_t>(length));
+    }
+
+    static std::size_t getLength(const uint8_t* src, std::size_t size, std::size_t& pos, std::size_t nibble) {
+        std::size_t length = nibble;
+        if (nibble < 15) return length;
+        uint8_t byte;
+        do {
+            if (pos >= size) corrupt();
+            byte = src[pos++];
+            length += byte;
+        } while (byte == 255);
+        return length;
+    }
+
+    static void putSequence(std::vector<uint8_t>& out, const uint8_t* literals, std::size_t count,
+                            std::size_t matchExtra) {
+        uint8_t token = static_cast<uint8_t>(((count < 15 ? count : 15) << 4) | (matchExtra < 15 ? matchExtra : 15));
+        out.push_back(token);
+        putLength(out, count);
+        out.insert(out.end(), literals, literals + count);
+    }
+
+    static void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static uint64_t getVarint(const uint8_t* src, std::size_t size, std::size_t& pos) {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64 && pos < size; shift += 7) {
+            uint8_t byte = src[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        corrupt();
+    }
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "memento.hpp"
+
+// Sequence of Memento snapshots stored as deltas. Every keyframeInterval-th
+// entry is kept whole, the others only hold the bytes that differ from the
+// entry before them, so rebuilding any entry replays at most
+// keyframeInterval - 1 deltas on top of its keyframe.
+//
+// A delta is a varint new size followed by (copy, literal) runs: copy bytes
+// are taken from the previous snapshot at the same offset, literal bytes
+// follow inline. Fields that change in place (what DataBuffer produces for
+// fixed-width values) cost only their own bytes; a field that changes length
+// shifts everything after it and degrades to a literal copy.
+class SnapshotHistory {
+public:
+    explicit SnapshotHistory(std::size_t keyframeInterval = 16)
+        : keyframeInterval_(keyframeInterval ? keyframeInterval : 1) {}
+
+    // Saves object and returns the index of the new entry.
+    std::size_t record(const Memento& object) {
+        return record(object.save());
+    }
+
+    // Compressed snapshots are expanded first, deltas need the raw bytes.
+    std::size_t record(const Memento::Snapshot& snapshot) {
+        if (snapshot.isCompressed()) {
+            return record(Memento::decompress(snapshot));
+        }
+        std::vector<uint8_t> bytes(snapshot.bytes(), snapshot.bytes() + snapshot.size());
+        Entry entry;
+        entry.keyframe = entries_.size() % keyframeInterval_ == 0;
+        if (entry.keyframe) {
+            entry.bytes = bytes;
+        } else {
+            encodeDelta(last_, bytes, entry.bytes);
+        }
+        storedBytes_ += entry.bytes.size();
+        entries_.push_back(std::move(entry));
+        last_.swap(bytes);
+        return entries_.size() - 1;
+    }
+
+    Memento::Snapshot snapshot(std::size_t index) const {
+        if (index >= entries_.size()) {
+            throw std::out_of_range("snapshot not found");
+        }
+        std::size_t first = index - index % keyframeInterval_;
+        std::vector<uint8_t> bytes = entries_[first].bytes;
+        std::vector<uint8_t> next;
+        for (std::size_t i = first + 1; i <= index; ++i) {
+            applyDelta(bytes, entries_[i].bytes, next);
+            bytes.swap(next);
+        }
+        Memento::Snapshot result;
+        result.insert(bytes.data(), bytes.size());
+        return result;
+    }
+
+    void restore(Memento& object, std::size_t index) const {
+        Memento::Snapshot state = snapshot(index);
+        object.load(state);
+    }
+
+    // Drops every entry after index, e.g. when rolling back and then
+    // recording a new future.
+    void truncate(std::size_t index) {
+        if (index + 1 >= entries_.size()) return;
+        last_ = snapshot(index).data();
+        for (std::size_t i = index + 1; i < entries_.size(); ++i) {
+            storedBytes_ -= entries_[i].bytes.size();
+        }
+        entries_.resize(index + 1);
+    }
+
+    void clear(void) {
+        entries_.clear();
+        last_.clear();
+        storedBytes_ = 0;
+    }
+
+    std::size_t size(void) const { return entries_.size(); }
+    bool isKeyframe(std::size_t index) const { return entries_.at(index).keyframe; }
+    std::size_t entryBytes(std::size_t index) const { return entries_.at(index).bytes.size(); }
+    std::size_t storedBytes(void) const { return storedBytes_; }
+
+private:
+    // Equal runs shorter than this are folded into the surrounding literal,
+    // a new run header would cost about as much.
+    static constexpr std::size_t minCopyRun = 4;
+
+    struct Entry {
+        bool                    keyframe = false;
+        std::vector<uint8_t>    bytes;
+    };
+
+    std::size_t             keyframeInterval_;
+    std::vector<Entry>      entries_;
+    std::vector<uint8_t>    last_;
+    std::size_t             storedBytes_ = 0;
+
+    static void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static uint64_t getVarint(const std::vector<uint8_t>& in, std::size_t& pos) {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= in.size()) break;
+            uint8_t byte = in[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("corrupt snapshot delta");
+    }
+
+    static void encodeDelta(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target,
+                            std::vector<uint8_t>& out) {
+        out.clear();
+        putVarint(out, target.size());
+        std::size_t common = std::min(base.size(), target.size());
+        std::size_t pos = 0;
+        while (pos < target.size()) {
+            std::size_t copyEnd = pos;
+            while (copyEnd < common && base[copyEnd] == target[copyEnd]) ++copyEnd;
+
+            // Literal runs until the next equal stretch worth a copy.
+            std::size_t literalEnd = copyEnd;
+            while (literalEnd < target.size()) {
+                std::size_t run = 0;
+                while (literalEnd + run < common && base[literalEnd + run] == target[literalEnd + run]
+                       && run < minCopyRun) {
+                    ++run;
+                }
+                if (run == minCopyRun || (literalEnd + run == target.size() && run > 0)) break;
+                literalEnd += run ? run : 1;
+            }
+
+            putVarint(out, copyEnd - pos);
+            putVarint(out, literalEnd - copyEnd);
+            out.insert(out.end(), target.begin() + copyEnd, target.begin() + literalEnd);
+            pos = literalEnd;
+        }
+    }
+
+    static void applyDelta(const std::vector<uint8_t>& base, const std::vector<uint8_t>& delta,
+                           std::vector<uint8_t>& out) {
+        std::size_t pos = 0;
+        uint64_t size = getVarint(delta, pos);
+        out.clear();
+        out.reserve(size);
+        while (out.size() < size) {
+            uint64_t copy = getVarint(delta, pos);
+            uint64_t literal = getVarint(delta, pos);
+            std::size_t at = out.size();
+            if (copy + literal == 0 || copy > base.size() - std::min<std::size_t>(at, base.size()) || literal > delta.size() - pos
+                || at + copy + literal > size) {
+                throw std::runtime_error("corrupt snapshot delta");
+            }
+            out.insert(out.end(), base.begin() + at, base.begin() + at + copy);
+            out.insert(out.end(), delta.begin() + pos, delta.begin() + pos + literal);
+            pos += literal;
+        }
+    }
+};
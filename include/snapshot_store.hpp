@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+#include "memento.hpp"
+
+// Append-only file of Memento snapshots, mapped read-only into memory.
+// append() writes a record header and the payload with one pwritev() and,
+// with Options::sync, waits for them to reach the disk. load() returns a
+// Snapshot that reads straight from the mapping, without copying; views
+// stay valid for the lifetime of the store. Compressed snapshots are stored
+// as they are and come back compressed.
+//
+// Opening an existing file rebuilds the index by walking the record
+// headers. A record cut short by a crash, or whose checksum does not match,
+// ends the log and is truncated away. Headers are stored in host byte
+// order: the file is meant for the machine that wrote it.
+class SnapshotStore {
+public:
+    struct Options {
+        // Address space reserved for the mapping, the file cannot grow past
+        // it. Only pages that hold snapshots are ever touched.
+        std::size_t reserveBytes = std::size_t(1) << (sizeof(void*) >= 8 ? 36 : 28);
+        bool        sync = true;
+    };
+
+    explicit SnapshotStore(const std::string& path) : SnapshotStore(path, Options()) {}
+
+    SnapshotStore(const std::string& path, const Options& options) : options_(options) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+        }
+        try {
+            struct stat st;
+            if (::fstat(fd_, &st) < 0) {
+                throw std::runtime_error("fstat failed");
+            }
+            end_ = static_cast<std::size_t>(st.st_size);
+            if (end_ == 0) {
+                writeAll(fileMagic, sizeof(fileMagic), 0);
+                end_ = sizeof(fileMagic);
+            } else if (end_ < sizeof(fileMagic)) {
+                throw std::runtime_error(path + " is not a snapshot store");
+            }
+            reserve_ = std::max(options_.reserveBytes, end_ * 2);
+            void* map = ::mmap(nullptr, reserve_, PROT_READ, MAP_SHARED, fd_, 0);
+            if (map == MAP_FAILED) {
+                throw std::runtime_error("mmap failed");
+            }
+            base_ = static_cast<const uint8_t*>(map);
+            if (std::memcmp(base_, fileMagic, sizeof(fileMagic)) != 0) {
+                throw std::runtime_error(path + " is not a snapshot store");
+            }
+            recover();
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    ~SnapshotStore(void) {
+        close();
+    }
+
+    SnapshotStore(const SnapshotStore&) = delete;
+    SnapshotStore& operator=(const SnapshotStore&) = delete;
+
+    // Returns the index of the new snapshot.
+    std::size_t append(const Memento::Snapshot& snapshot) {
+        std::size_t size = snapshot.size();
+        std::size_t padded = (size + alignment - 1) & ~(alignment - 1);
+        if (end_ + sizeof(Header) + padded > reserve_) {
+            throw std::length_error("snapshot store is full");
+        }
+
+        Header header;
+        header.magic = snapshot.isCompressed() ? compressedMagic : recordMagic;
+        header.size = size;
+        header.sequence = index_.size();
+        header.checksum = checksum(snapshot.bytes(), size);
+
+        static const uint8_t zeros[alignment] = {};
+        iovec parts[3] = {
+            {&header, sizeof(header)},
+            {const_cast<uint8_t*>(snapshot.bytes()), size},
+            {const_cast<uint8_t*>(zeros), padded - size},
+        };
+        writeAll(parts, 3, end_);
+        if (options_.sync) {
+            sync();
+        }
+        index_.push_back(end_ + sizeof(Header));
+        sizes_.push_back(size);
+        compressed_.push_back(snapshot.isCompressed());
+        end_ += sizeof(Header) + padded;
+        return index_.size() - 1;
+    }
+
+    std::size_t append(const Memento& object) {
+        return append(object.save());
+    }
+
+    // Read-only view into the mapping.
+    Memento::Snapshot load(std::size_t index) const {
+        if (index >= index_.size()) {
+            throw std::out_of_range("snapshot not found");
+        }
+        Memento::Snapshot snapshot;
+        snapshot.wrap(base_ + index_[index], sizes_[index]);
+        snapshot.compressed_ = compressed_[index];
+        return snapshot;
+    }
+
+    void restore(Memento& object, std::size_t index) const {
+        Memento::Snapshot snapshot = load(index);
+        object.load(snapshot);
+    }
+
+    // Restores the newest snapshot, returns false if there is none.
+    bool restoreLatest(Memento& object) const {
+        if (index_.empty()) return false;
+        restore(object, index_.size() - 1);
+        return true;
+    }
+
+    std::size_t size(void) const { return index_.size(); }
+    std::size_t fileBytes(void) const { return end_; }
+
+private:
+    static constexpr uint8_t fileMagic[8] = {'F', 'T', 'P', 'P', 'S', 'N', 'P', '1'};
+    static constexpr uint32_t recordMagic = 0x534E4150;       // "SNAP"
+    static constexpr uint32_t compressedMagic = 0x534E505A;   // "SNPZ"
+    static constexpr std::size_t alignment = 8;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t checksum;
+        uint64_t size;
+        uint64_t sequence;
+    };
+
+    Options                 options_;
+    int                     fd_ = -1;
+    const uint8_t*          base_ = nullptr;
+    std::size_t             reserve_ = 0;
+    std::size_t             end_ = 0;
+    std::vector<std::size_t> index_;    // payload offsets
+    std::vector<std::size_t> sizes_;
+    std::vector<bool>       compressed_;
+
+    // FNV-1a, folded to 32 bits.
+    static uint32_t checksum(const uint8_t* data, std::size_t size) {
+        uint64_t hash = 14695981039346656037ull;
+        for (std::size_t i = 0; i < size; ++i) {
+            hash = (hash ^ data[i]) * 1099511628211ull;
+        }
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
+
+    void recover(void) {
+        std::size_t offset = sizeof(fileMagic);
+        while (offset + sizeof(Header) <= end_) {
+            Header header;
+            std::memcpy(&header, base_ + offset, sizeof(header));
+            std::size_t payload = offset + sizeof(Header);
+            if ((header.magic != recordMagic && header.magic != compressedMagic) || header.sequence != index_.size()
+                || header.size > end_ - payload
+                || ((header.size + alignment - 1) & ~(alignment - 1)) > end_ - payload
+                || checksum(base_ + payload, header.size) != header.checksum) {
+                break;
+            }
+            index_.push_back(payload);
+            sizes_.push_back(header.size);
+            compressed_.push_back(header.magic == compressedMagic);
+            offset = payload + ((header.size + alignment - 1) & ~(alignment - 1));
+        }
+        if (offset < end_) {
+            if (::ftruncate(fd_, static_cast<off_t>(offset)) < 0) {
+                throw std::runtime_error("cannot truncate damaged snapshot store");
+            }
+            end_ = offset;
+        }
+    }
+
+    void writeAll(const void* data, std::size_t size, std::size_t offset) {
+        iovec part = {const_cast<void*>(data), size};
+        writeAll(&part, 1, offset);
+    }
+
+    void writeAll(iovec* parts, int count, std::size_t offset) {
+        while (count > 0) {
+            ssize_t n = ::pwritev(fd_, parts, count, static_cast<off_t>(offset));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("snapshot write failed: ") + std::strerror(errno));
+            }
+            offset += static_cast<std::size_t>(n);
+            std::size_t left = static_cast<std::size_t>(n);
+            while (count > 0 && left >= parts->iov_len) {
+                left -= parts->iov_len;
+                ++parts;
+                --count;
+            }
+            if (count > 0) {
+                parts->iov_base = static_cast<uint8_t*>(parts->iov_base) + left;
+                parts->iov_len -= left;
+            }
+        }
+    }
+
+    void sync(void) {
+#ifdef __linux__
+        int result = ::fdatasync(fd_);
+#else
+        int result = ::fsync(fd_);
+#endif
+        if (result < 0) {
+            throw std::runtime_error(std::string("snapshot sync failed: ") + std::strerror(errno));
+        }
+    }
+
+    void close(void) {
+        if (base_) {
+            ::munmap(const_cast<uint8_t*>(base_), reserve_);
+            base_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+};
@@ -1,15 +1,82 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <map>
 #include <functional>
+#include <limits>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
 
+// Transitions are registered in maps. compile() turns them into a dense
+// table indexed by state, after which update() and transitionTo() are an
+// indexed call (a direct array lookup for enum and integer states). Each
+// cell holds an index into the shared action list, never a copy of the
+// action. Registrations after compile() keep the table current: actions
+// between known states are patched in place, a new state rebuilds it.
 template<typename TState>
 class StateMachine {
 private:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+    static constexpr bool directIndex = std::is_enum_v<TState> || std::is_integral_v<TState>;
+    static constexpr long long maxDirectRange = 1 << 16;
+
     bool isSet = false;
     TState currentState;
-    std::map<TState, std::map<TState, std::function<void()>>> relationsMap;
+    std::deque<std::function<void()>> actions;     // stable while an action registers more
+    std::map<TState, std::map<TState, std::size_t>> relationsMap;   // -> actions
+
+    bool compiled = false;
+    std::vector<TState> states;
+    std::vector<uint32_t> table;                    // [from * states.size() + to] -> action + 1
+    std::size_t currentIndex = 0;
+    std::vector<std::size_t> byValue;               // enum/integer value - minValue -> index
+    long long minValue = 0;
+    std::map<TState, std::size_t> byState;          // other state types
+
+    static long long valueOf(const TState& state) {
+        if constexpr (directIndex) return static_cast<long long>(state);
+        else return 0;
+    }
+
+    std::size_t indexOf(const TState& state) const {
+        if (!byValue.empty()) {
+            long long offset = valueOf(state) - minValue;
+            if (offset < 0 || offset >= static_cast<long long>(byValue.size())) return npos;
+            return byValue[static_cast<std::size_t>(offset)];
+        }
+        auto it = byState.find(state);
+        return it == byState.end() ? npos : it->second;
+    }
+
+    const std::function<void()>* find(const TState& from, const TState& to) const {
+        auto row = relationsMap.find(from);
+        if (row == relationsMap.end()) return nullptr;
+        auto cell = row->second.find(to);
+        return cell == row->second.end() ? nullptr : &actions[cell->second];
+    }
+
+    // Returns true if the state was not registered yet.
+    bool addKnown(const TState& state) {
+        return relationsMap.try_emplace(state).second;
+    }
+
+    void setRelation(const TState& from, const TState& to, const std::function<void()>& lambda) {
+        bool added = addKnown(to);
+        added = addKnown(from) || added;
+        auto [cell, inserted] = relationsMap[from].try_emplace(to, actions.size());
+        if (inserted) actions.push_back(lambda);
+        else actions[cell->second] = lambda;
+        if (!compiled) return;
+        if (added) {
+            compile();
+            return;
+        }
+        table[indexOf(from) * states.size() + indexOf(to)] = static_cast<uint32_t>(cell->second + 1);
+    }
 
 public:
     void addState(const TState& state) {
@@ -17,30 +84,111 @@ public:
             currentState = state;
             isSet = true;
         }
+        if (addKnown(state) && compiled) compile();
     }
 
     void addAction(const TState& state, const std::function<void()>& lambda) {
-        relationsMap[state][state] = lambda;
+        setRelation(state, state, lambda);
     }
 
     void addTransition(const TState& startState, const TState& finalState, const std::function<void()>& lambda) {
-        relationsMap[startState][finalState] = lambda;
+        setRelation(startState, finalState, lambda);
+    }
+
+    // Builds the dense transition table from everything registered so far.
+    void compile(void) {
+        states.clear();
+        byValue.clear();
+        byState.clear();
+        for (const auto& [state, row] : relationsMap) {
+            states.push_back(state);
+        }
+
+        std::size_t count = states.size();
+        if constexpr (directIndex) {
+            if (count > 0) {
+                long long lo = valueOf(states.front());
+                long long hi = lo;
+                for (const TState& s : states) {
+                    lo = std::min(lo, valueOf(s));
+                    hi = std::max(hi, valueOf(s));
+                }
+                if (hi - lo < maxDirectRange) {
+                    minValue = lo;
+                    byValue.assign(static_cast<std::size_t>(hi - lo + 1), npos);
+                    for (std::size_t i = 0; i < count; ++i) {
+                        byValue[static_cast<std::size_t>(valueOf(states[i]) - lo)] = i;
+                    }
+                }
+            }
+        }
+        if (byValue.empty()) {
+            for (std::size_t i = 0; i < count; ++i) byState[states[i]] = i;
+        }
+
+        table.assign(count * count, 0);
+        for (const auto& [from, row] : relationsMap) {
+            std::size_t f = indexOf(from);
+            for (const auto& [to, action] : row) {
+                table[f * count + indexOf(to)] = static_cast<uint32_t>(action + 1);
+            }
+        }
+        currentIndex = isSet ? indexOf(currentState) : 0;
+        compiled = true;
+    }
+
+    bool isCompiled(void) const {
+        return compiled;
+    }
+
+    // Same as transitionTo() but returns false instead of throwing when
+    // there is no such transition.
+    bool tryTransitionTo(const TState& state) {
+        if (compiled) {
+            std::size_t to = indexOf(state);
+            if (!isSet || to == npos) return false;
+            std::size_t count = states.size();
+            uint32_t cell = table[currentIndex * count + to];
+            if (cell == 0 || !actions[cell - 1]) return false;
+            actions[cell - 1]();
+            // The action may have added states, which renumbers them.
+            if (states.size() != count) to = indexOf(state);
+            currentIndex = to;
+            currentState = states[to];
+            return true;
+        }
+        const std::function<void()>* action = isSet ? find(currentState, state) : nullptr;
+        if (action == nullptr || !*action) return false;
+        (*action)();
+        currentState = state;
+        return true;
+    }
+
+    // Same as update() but returns false instead of throwing when the
+    // current state has no action.
+    bool tryUpdate(void) {
+        if (compiled) {
+            if (!isSet) return false;
+            uint32_t cell = table[currentIndex * (states.size() + 1)];
+            if (cell == 0 || !actions[cell - 1]) return false;
+            actions[cell - 1]();
+            return true;
+        }
+        const std::function<void()>* action = isSet ? find(currentState, currentState) : nullptr;
+        if (action == nullptr || !*action) return false;
+        (*action)();
+        return true;
     }
 
     void transitionTo(const TState& state) {
-        try {
-            relationsMap.at(currentState).at(state)();
-            currentState = state;
-        } catch(const std::out_of_range& e) {
+        if (!tryTransitionTo(state)) {
             throw std::invalid_argument("state not found");
         }
     }
 
     void update() {
-        try {
-            relationsMap.at(currentState).at(currentState)();
-        } catch(const std::out_of_range& e) {
+        if (!tryUpdate()) {
             throw std::invalid_argument("state not found");
         }
     }
-};
\ No newline at end of file
+};
@@ -1,26 +1,234 @@
 #pragma once
 
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <ostream>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "mpsc_queue.hpp"
+
+// Process-wide destination of every threadSafeCout statement. By default a
+// statement is written to std::cout and flushed under one global lock.
+// In async mode statements are pushed on a lock-free queue and a
+// background thread writes them in large batches with write(2).
+class LogWriter {
+public:
+    struct AsyncOptions {
+        int                         fd = STDOUT_FILENO;
+        std::size_t                 batchBytes = 64 * 1024;                 // write early once this much is queued
+        std::chrono::milliseconds   flushInterval{5};                       // longest a record waits, 0 writes at once
+    };
+
+    static LogWriter& instance(void) {
+        static LogWriter writer;
+        return writer;
+    }
+
+    ~LogWriter(void) {
+        disableAsync();
+    }
+
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    void enableAsync(void) {
+        enableAsync(AsyncOptions());
+    }
+
+    void enableAsync(const AsyncOptions& options) {
+        std::lock_guard<std::mutex> lock(syncMutex_);
+        if (async_.load(std::memory_order_acquire)) return;
+        std::cout.flush();
+        options_ = options;
+        stopping_ = false;
+        writer_ = std::thread(&LogWriter::writerLoop, this);
+        async_.store(true, std::memory_order_release);
+    }
+
+    // Writes everything still queued, then goes back to synchronous output.
+    void disableAsync(void) {
+        std::lock_guard<std::mutex> lock(syncMutex_);
+        if (!async_.exchange(false, std::memory_order_seq_cst)) return;
+        // A write() that saw async_ still set finishes its push first, later
+        // ones take the synchronous path and wait for syncMutex_.
+        while (writers_.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> wakeLock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+
+        // Records pushed while the writer was shutting down.
+        std::string batch;
+        while (std::optional<std::string> record = queue_.try_pop()) {
+            batch += *record;
+            pendingBytes_.fetch_sub(record->size(), std::memory_order_acq_rel);
+        }
+        writeAll(batch);
+    }
+
+    bool async(void) const {
+        return async_.load(std::memory_order_acquire);
+    }
+
+    void write(std::string&& record) {
+        writers_.fetch_add(1, std::memory_order_seq_cst);
+        if (!async_.load(std::memory_order_seq_cst)) {
+            writers_.fetch_sub(1, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(syncMutex_);
+            std::cout << record;
+            std::cout.flush();
+            return;
+        }
+
+        std::size_t length = record.size();
+        queue_.push(std::move(record));
+        submitted_.fetch_add(1, std::memory_order_release);
+        std::size_t before = pendingBytes_.fetch_add(length, std::memory_order_acq_rel);
+        if (before == 0 || options_.flushInterval.count() == 0
+            || (before < options_.batchBytes && before + length >= options_.batchBytes)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake_.notify_one();
+        }
+        writers_.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Blocks until every record written before the call reached the file
+    // descriptor.
+    void flush(void) {
+        if (!async_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(syncMutex_);
+            std::cout.flush();
+            return;
+        }
+        uint64_t target = submitted_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex_);
+        flushRequested_ = true;
+        wake_.notify_one();
+        done_.wait(lock, [&] { return written_ >= target || stopping_; });
+    }
+
+    // Serialises console input between threads. Output is not held up
+    // while a thread waits for input.
+    std::mutex& inputMutex(void) {
+        return inputMutex_;
+    }
+
+private:
+    LogWriter(void) = default;
+
+    void writerLoop(void) {
+        std::string batch;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this] {
+                return stopping_ || flushRequested_ || pendingBytes_.load(std::memory_order_acquire) > 0;
+            });
+            if (!stopping_ && !flushRequested_) {
+                wake_.wait_for(lock, options_.flushInterval, [this] {
+                    return stopping_ || flushRequested_
+                        || pendingBytes_.load(std::memory_order_acquire) >= options_.batchBytes;
+                });
+            }
+            flushRequested_ = false;
+            bool last = stopping_;
+            lock.unlock();
+
+            uint64_t count = 0;
+            std::size_t bytes = 0;
+            while (std::optional<std::string> record = queue_.try_pop()) {
+                batch += *record;
+                bytes += record->size();
+                ++count;
+                if (batch.size() >= options_.batchBytes) writeAll(batch);
+            }
+            writeAll(batch);
+            pendingBytes_.fetch_sub(bytes, std::memory_order_acq_rel);
+
+            lock.lock();
+            written_ += count;
+            done_.notify_all();
+            if (last && queue_.empty()) return;
+        }
+    }
+
+    void writeAll(std::string& batch) {
+        std::size_t offset = 0;
+        while (offset < batch.size()) {
+            ssize_t n = ::write(options_.fd, batch.data() + offset, batch.size() - offset);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            offset += static_cast<std::size_t>(n);
+        }
+        batch.clear();
+    }
+
+    std::mutex                      syncMutex_;
+    std::mutex                      inputMutex_;
+    std::atomic<bool>               async_{false};
+    std::atomic<std::size_t>        writers_{0};      // write() calls on the async path
+    AsyncOptions                    options_;
+    std::thread                     writer_;
+
+    MpscQueue<std::string>          queue_;
+    std::atomic<uint64_t>           submitted_{0};
+    std::atomic<std::size_t>        pendingBytes_{0};
+    std::mutex                      mutex_;
+    std::condition_variable         wake_;
+    std::condition_variable         done_;
+    uint64_t                        written_ = 0;
+    bool                            flushRequested_ = false;
+    bool                            stopping_ = false;
+};
 
 class ThreadSafeIOStream {
 private:
     std::string prefix_;
-    std::mutex mtx_;
+    uint64_t prefixVersion_ = 0;
+    std::ostringstream buffer_;
+    bool bufferBusy_ = false;
 
+    // Formats one statement into the thread's reusable buffer (or its own
+    // stream when statements nest) and hands it to LogWriter when done.
     class Proxy {
     private:
         ThreadSafeIOStream& parent_;
-        std::unique_lock<std::mutex> lock_;
-        std::ostringstream oss_;
+        std::unique_ptr<std::ostringstream> local_;
+        std::ostringstream* oss_;
         bool prefixAdded_{false};
+        bool active_{true};
     public:
         Proxy(ThreadSafeIOStream& parent)
-            : parent_(parent), lock_(parent_.mtx_) {}
-        Proxy(Proxy&&) = default;
+            : parent_(parent), oss_(&parent.buffer_) {
+            if (parent_.bufferBusy_) {
+                local_ = std::make_unique<std::ostringstream>();
+                oss_ = local_.get();
+            } else {
+                parent_.bufferBusy_ = true;
+                parent_.buffer_.str(std::string());
+                parent_.buffer_.clear();
+            }
+        }
+        Proxy(Proxy&& other)
+            : parent_(other.parent_), local_(std::move(other.local_)), oss_(other.oss_),
+              prefixAdded_(other.prefixAdded_), active_(other.active_) {
+            other.active_ = false;
+        }
         Proxy(const Proxy&) = delete;
         Proxy& operator=(const Proxy&) = delete;
 
@@ -28,29 +236,32 @@ private:
         template<typename T>
         Proxy& operator<<(const T& data) {
             if (!prefixAdded_) {
-                oss_ << parent_.prefix_;
+                *oss_ << parent_.prefix_;
                 prefixAdded_ = true;
             }
-            oss_ << data;
+            *oss_ << data;
             return *this;
         }
 
         Proxy& operator<<(std::ostream& (*manip)(std::ostream&)) {
             if (manip == static_cast<std::ostream& (*)(std::ostream&)>(std::endl)) {
                 if (!prefixAdded_) {
-                    oss_ << parent_.prefix_;
+                    *oss_ << parent_.prefix_;
                     prefixAdded_ = true;
                 }
-                oss_ << '\n';
+                *oss_ << '\n';
             } else {
-                oss_ << manip;
+                *oss_ << manip;
             }
             return *this;
         }
 
         ~Proxy() {
-            std::cout << oss_.str();
-            std::cout.flush();
+            if (!active_) return;
+            LogWriter::instance().write(oss_->str());
+            if (oss_ == &parent_.buffer_) {
+                parent_.bufferBusy_ = false;
+            }
         }
     };
 
@@ -68,15 +279,27 @@ public:
         return p;
     }
 
+    // The prefix belongs to the calling thread, threadSafeCout being
+    // thread_local.
     void setPrefix(const std::string& prefix) {
-        std::lock_guard<std::mutex> lock(mtx_);
         prefix_ = prefix;
+        ++prefixVersion_;
+    }
+
+    const std::string& prefix(void) const {
+        return prefix_;
+    }
+
+    // Changes with every setPrefix(), lets readers cache the prefix.
+    uint64_t prefixVersion(void) const {
+        return prefixVersion_;
     }
 
     template<typename T>
     void prompt(const std::string& question, T& dest) {
         *this << question << std::endl;
-        std::lock_guard<std::mutex> lock(mtx_);
+        LogWriter::instance().flush();
+        std::lock_guard<std::mutex> lock(LogWriter::instance().inputMutex());
         std::cin >> dest;
     }
 };
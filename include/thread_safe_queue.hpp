@@ -1,25 +1,160 @@
 #pragma once
 
-#include <deque>
+#include <chrono>
+#include <condition_variable>
 #include <exception>
 #include <iterator>
 #include <mutex>
+#include <new>
+#include <optional>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 template<typename TType>
 class ThreadSafeQueue {
 private:
-    std::deque<TType> deque;
+    // Growable circular buffer. Unlike std::deque it keeps its storage once
+    // grown, so steady push/pop traffic does not allocate.
+    class Ring {
+    private:
+        TType*      data_ = nullptr;
+        std::size_t capacity_ = 0;
+        std::size_t head_ = 0;
+        std::size_t size_ = 0;
+
+        std::size_t slot(std::size_t i) const { return (head_ + i) & (capacity_ - 1); }
+
+        void grow() {
+            std::size_t newCap = capacity_ ? capacity_ * 2 : 16;
+            TType* newData = static_cast<TType*>(operator new[](newCap * sizeof(TType), std::align_val_t(alignof(TType))));
+            for (std::size_t i = 0; i < size_; ++i) {
+                new (&newData[i]) TType(std::move(data_[slot(i)]));
+                data_[slot(i)].~TType();
+            }
+            if (data_) operator delete[](data_, std::align_val_t(alignof(TType)));
+            data_ = newData;
+            capacity_ = newCap;
+            head_ = 0;
+        }
+
+    public:
+        Ring() = default;
+        Ring(const Ring&) = delete;
+        Ring& operator=(const Ring&) = delete;
+
+        ~Ring() {
+            while (size_) pop_front();
+            if (data_) operator delete[](data_, std::align_val_t(alignof(TType)));
+        }
+
+        bool empty() const { return size_ == 0; }
+        std::size_t size() const { return size_; }
+
+        TType& front() { return data_[head_]; }
+        TType& back() { return data_[slot(size_ - 1)]; }
+
+        template<typename TArg>
+        void push_back(TArg&& value) {
+            if (size_ == capacity_) grow();
+            new (&data_[slot(size_)]) TType(std::forward<TArg>(value));
+            ++size_;
+        }
+
+        template<typename TArg>
+        void push_front(TArg&& value) {
+            if (size_ == capacity_) grow();
+            std::size_t index = (head_ + capacity_ - 1) & (capacity_ - 1);
+            new (&data_[index]) TType(std::forward<TArg>(value));
+            head_ = index;
+            ++size_;
+        }
+
+        void pop_front() {
+            data_[head_].~TType();
+            head_ = slot(1);
+            --size_;
+        }
+
+        void pop_back() {
+            back().~TType();
+            --size_;
+        }
+    };
+
+    Ring deque;
     std::mutex mutex;
+    std::condition_variable condition;
+    bool closed = false;
+
+    void checkOpen(void) const {
+        if (closed) {
+            throw std::runtime_error("push on closed queue");
+        }
+    }
+
+    std::optional<TType> takeFront(void) {
+        if (deque.empty()) {
+            return std::nullopt;
+        }
+        std::optional<TType> t(std::move(deque.front()));
+        deque.pop_front();
+        return t;
+    }
+
 public:
     void push_back(const TType& newElement) {
-        std::lock_guard<std::mutex> lg(mutex);
-        deque.push_back(newElement);
+        {
+            std::lock_guard<std::mutex> lg(mutex);
+            checkOpen();
+            deque.push_back(newElement);
+        }
+        condition.notify_one();
+    }
+
+    void push_back(TType&& newElement) {
+        {
+            std::lock_guard<std::mutex> lg(mutex);
+            checkOpen();
+            deque.push_back(std::move(newElement));
+        }
+        condition.notify_one();
     }
 
     void push_front(const TType& newElement) {
-        std::lock_guard<std::mutex> lg(mutex);
-        deque.push_front(newElement);
+        {
+            std::lock_guard<std::mutex> lg(mutex);
+            checkOpen();
+            deque.push_front(newElement);
+        }
+        condition.notify_one();
+    }
+
+    void push_front(TType&& newElement) {
+        {
+            std::lock_guard<std::mutex> lg(mutex);
+            checkOpen();
+            deque.push_front(std::move(newElement));
+        }
+        condition.notify_one();
+    }
+
+    // Appends [first, last) under a single lock acquisition.
+    template<typename TIterator>
+    void push_bulk(TIterator first, TIterator last) {
+        std::size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lg(mutex);
+            checkOpen();
+            for (; first != last; ++first, ++count) {
+                deque.push_back(*first);
+            }
+        }
+        if (count == 1) {
+            condition.notify_one();
+        } else if (count > 1) {
+            condition.notify_all();
+        }
     }
 
     TType pop_back(void) {
@@ -27,7 +162,7 @@ public:
         if (deque.empty()) {
             throw std::runtime_error("pop on empty queue");
         }
-        TType t = deque.back();
+        TType t = std::move(deque.back());
         deque.pop_back();
         return t;
     }
@@ -37,10 +172,63 @@ public:
         if (deque.empty()) {
             throw std::runtime_error("pop on empty queue");
         }
-        TType t = deque.front();
+        TType t = std::move(deque.front());
         deque.pop_front();
         return t;
     }
 
-    bool empty() { return deque.empty(); }
-};
\ No newline at end of file
+    // Non-blocking pop_front(), returns nothing when the queue is empty.
+    std::optional<TType> try_pop(void) {
+        std::lock_guard<std::mutex> lg(mutex);
+        return takeFront();
+    }
+
+    // Moves up to maxItems elements from the front into `out` under a single
+    // lock acquisition, without waiting. Returns how many were taken.
+    std::size_t pop_bulk(std::vector<TType>& out, std::size_t maxItems) {
+        std::lock_guard<std::mutex> lg(mutex);
+        std::size_t count = 0;
+        while (count < maxItems && !deque.empty()) {
+            out.push_back(std::move(deque.front()));
+            deque.pop_front();
+            ++count;
+        }
+        return count;
+    }
+
+    // Blocks until an element is available. Returns nothing once the queue
+    // is closed and drained.
+    std::optional<TType> wait_pop(void) {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return closed || !deque.empty(); });
+        return takeFront();
+    }
+
+    // Same as wait_pop(), but also returns nothing when timeout expires.
+    template<typename TRep, typename TPeriod>
+    std::optional<TType> wait_pop(const std::chrono::duration<TRep, TPeriod>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait_for(lock, timeout, [this] { return closed || !deque.empty(); });
+        return takeFront();
+    }
+
+    // Rejects further pushes and wakes every waiter. Elements already queued
+    // can still be popped.
+    void close(void) {
+        {
+            std::lock_guard<std::mutex> lg(mutex);
+            closed = true;
+        }
+        condition.notify_all();
+    }
+
+    bool is_closed() {
+        std::lock_guard<std::mutex> lg(mutex);
+        return closed;
+    }
+
+    bool empty() {
+        std::lock_guard<std::mutex> lg(mutex);
+        return deque.empty();
+    }
+};
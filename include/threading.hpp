@@ -1,4 +1,8 @@
 #include "thread_safe_queue.hpp"
+#include "lock_free_queue.hpp"
+#include "mpsc_queue.hpp"
+#include "work_stealing_deque.hpp"
 #include "thread.hpp"
 #include "worker_pool.hpp"
+#include "parallel_algorithms.hpp"
 #include "persistent_worker.hpp"
\ No newline at end of file
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Hierarchical timing wheel (Varghese & Lauck). Four levels of 64 slots,
+// each level 64 times coarser than the one below, cover about 4.6 hours at
+// the default 1 ms tick; longer timers are parked in the top level and
+// re-filed as time passes. Timers live in intrusive lists so schedule and
+// cancel are O(1), and an occupancy bitmap per level gives the next
+// deadline without scanning. Not thread-safe: owned by one event loop.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = uint64_t;
+
+    static constexpr TimerId invalidTimer = 0;
+
+    explicit TimerWheel(Clock::duration tick = std::chrono::milliseconds(1), Clock::time_point start = Clock::now())
+        : tick_(tick), start_(start) {
+        for (auto& level : heads_) {
+            for (uint32_t& head : level) head = nil;
+        }
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Runs callback from advance() once delay has elapsed, counted from the
+    // last advance() and rounded up to the next tick.
+    TimerId schedule(Clock::duration delay, std::function<void()> callback) {
+        uint32_t index;
+        if (free_ != nil) {
+            index = free_;
+            free_ = nodes_[index].next;
+        } else {
+            index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+
+        Node& node = nodes_[index];
+        uint64_t ticks = delay <= Clock::duration::zero() ? 1
+            : static_cast<uint64_t>((delay + tick_ - Clock::duration(1)) / tick_);
+        node.expires = now_ + (ticks ? ticks : 1);
+        node.callback = std::move(callback);
+        node.active = true;
+        link(index);
+        ++count_;
+        return (static_cast<TimerId>(node.generation) << 32) | (index + 1);
+    }
+
+    // Returns false if the timer already fired or was cancelled.
+    bool cancel(TimerId id) {
+        uint32_t index = static_cast<uint32_t>(id & 0xFFFFFFFFu) - 1;
+        if (id == invalidTimer || index >= nodes_.size()) return false;
+        Node& node = nodes_[index];
+        if (!node.active || node.generation != static_cast<uint32_t>(id >> 32)) return false;
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    // Fires every timer due at `now`, in deadline order (ties in no
+    // particular order). Callbacks may schedule and cancel timers.
+    void advance(Clock::time_point now) {
+        uint64_t target = ticksAt(now);
+        while (now_ < target) {
+            if (count_ == 0) {
+                now_ = target;
+                break;
+            }
+            // Jump straight to the next occupied level-0 slot or the next
+            // cascade boundary, whichever comes first.
+            uint64_t boundary = (now_ | slotMask) + 1;
+            uint64_t step = std::min(target, boundary);
+            uint64_t next = nextInLevel(0);
+            if (next != 0 && now_ + next < step) step = now_ + next;
+            now_ = step;
+
+            if ((now_ & slotMask) == 0) cascade();
+            expire(static_cast<std::size_t>(now_ & slotMask));
+        }
+    }
+
+    // Milliseconds until the next timer may need attention, -1 when there
+    // are none. Meant to be used as a poll/epoll timeout.
+    int timeoutMs(Clock::time_point now) const {
+        if (count_ == 0) return -1;
+        uint64_t due = std::numeric_limits<uint64_t>::max();
+        for (std::size_t level = 0; level < levels; ++level) {
+            uint64_t distance = nextInLevel(level);
+            if (distance == 0) continue;
+            uint64_t shift = level * slotBits;
+            uint64_t tick = ((now_ >> shift) + distance) << shift;
+            if (tick < due) due = tick;
+        }
+        auto wait = start_ + tick_ * static_cast<int64_t>(due) - now;
+        if (wait <= Clock::duration::zero()) return 0;
+        auto ms = std::chrono::ceil<std::chrono::milliseconds>(wait).count();
+        return ms > std::numeric_limits<int>::max() ? std::numeric_limits<int>::max() : static_cast<int>(ms);
+    }
+
+    std::size_t size(void) const { return count_; }
+
+private:
+    static constexpr std::size_t levels = 4;
+    static constexpr std::size_t slotBits = 6;
+    static constexpr std::size_t slots = std::size_t(1) << slotBits;
+    static constexpr uint64_t    slotMask = slots - 1;
+    static constexpr uint32_t    nil = std::numeric_limits<uint32_t>::max();
+
+    struct Node {
+        uint64_t                expires = 0;
+        std::function<void()>   callback;
+        uint32_t                prev = nil;
+        uint32_t                next = nil;
+        uint32_t                generation = 0;
+        uint16_t                level = 0;
+        uint16_t                slot = 0;
+        bool                    active = false;
+    };
+
+    uint64_t ticksAt(Clock::time_point now) const {
+        if (now <= start_) return 0;
+        return static_cast<uint64_t>((now - start_) / tick_);
+    }
+
+    // Distance in slots from the current position of `level` to its next
+    // occupied slot, 0 if the level is empty.
+    uint64_t nextInLevel(std::size_t level) const {
+        uint64_t bits = occupied_[level];
+        if (bits == 0) return 0;
+        unsigned from = static_cast<unsigned>(((now_ >> (level * slotBits)) + 1) & slotMask);
+        uint64_t rotated = from ? (bits >> from) | (bits << (slots - from)) : bits;
+        return static_cast<uint64_t>(__builtin_ctzll(rotated)) + 1;
+    }
+
+    void link(uint32_t index) {
+        Node& node = nodes_[index];
+        uint64_t delta = node.expires > now_ ? node.expires - now_ : 0;
+        std::size_t level = 0;
+        while (level + 1 < levels && delta >= (uint64_t(1) << ((level + 1) * slotBits))) ++level;
+
+        uint64_t when = node.expires;
+        uint64_t horizon = uint64_t(1) << (levels * slotBits);
+        if (delta >= horizon) when = now_ + horizon - 1;
+        std::size_t slot = static_cast<std::size_t>((when >> (level * slotBits)) & slotMask);
+
+        node.level = static_cast<uint16_t>(level);
+        node.slot = static_cast<uint16_t>(slot);
+        node.prev = nil;
+        node.next = heads_[level][slot];
+        if (node.next != nil) nodes_[node.next].prev = index;
+        heads_[level][slot] = index;
+        occupied_[level] |= uint64_t(1) << slot;
+    }
+
+    void unlink(uint32_t index) {
+        Node& node = nodes_[index];
+        if (node.prev != nil) nodes_[node.prev].next = node.next;
+        else heads_[node.level][node.slot] = node.next;
+        if (node.next != nil) nodes_[node.next].prev = node.prev;
+        if (heads_[node.level][node.slot] == nil) {
+            occupied_[node.level] &= ~(uint64_t(1) << node.slot);
+        }
+    }
+
+    void release(uint32_t index) {
+        Node& node = nodes_[index];
+        node.callback = nullptr;
+        node.active = false;
+        ++node.generation;
+        node.next = free_;
+        free_ = index;
+        --count_;
+    }
+
+    // Re-files the timers of the higher-level slots that just came due
+    // into finer levels.
+    void cascade(void) {
+        for (std::size_t level = 1; level < levels; ++level) {
+            std::size_t slot = static_cast<std::size_t>((now_ >> (level * slotBits)) & slotMask);
+            uint32_t index = heads_[level][slot];
+            heads_[level][slot] = nil;
+            occupied_[level] &= ~(uint64_t(1) << slot);
+            while (index != nil) {
+                uint32_t next = nodes_[index].next;
+                link(index);
+                index = next;
+            }
+            if (slot != 0) break;
+        }
+    }
+
+    void expire(std::size_t slot) {
+        while (heads_[0][slot] != nil) {
+            uint32_t index = heads_[0][slot];
+            unlink(index);
+            std::function<void()> callback = std::move(nodes_[index].callback);
+            release(index);
+            callback();
+        }
+    }
+
+    Clock::duration                 tick_;
+    Clock::time_point               start_;
+    uint64_t                        now_ = 0;
+    std::size_t                     count_ = 0;
+    uint32_t                        free_ = nil;
+    std::vector<Node>               nodes_;
+    uint32_t                        heads_[levels][slots];
+    uint64_t                        occupied_[levels] = {};
+};
@@ -1,33 +1,84 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <type_traits>
+#include <variant>
 #include <vector>
 #include <thread>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <condition_variable>
-#include "thread_safe_queue.hpp"
+#include <optional>
+#include <string>
+#include "concurrent_pool.hpp"
+#include "cpu_topology.hpp"
+#include "inline_job.hpp"
+#include "work_stealing_deque.hpp"
+
+// Bytes of captured state a job may carry before it spills to the heap.
+#ifndef FTPP_JOB_INLINE_SIZE
+#define FTPP_JOB_INLINE_SIZE 64
+#endif
+
+template<typename TType>
+class TaskFuture;
 
 class WorkerPool {
 public:
-    class IJob {
-    public:
-        IJob(std::function<void()> f) : func_(std::move(f)) {}
-        void run() { func_(); }
-    private:
-        std::function<void()> func_;
+    using IJob = InlineJob<FTPP_JOB_INLINE_SIZE>;
+
+    // SharedQueue: every job goes through the shared lanes.
+    // WorkStealing: each worker owns a deque, jobs added from inside a job
+    // stay on that worker, and idle workers steal from the others. Jobs
+    // added from outside the pool go through the lanes, normal priority
+    // ones are drained in batches.
+    enum class Scheduling { SharedQueue, WorkStealing };
+
+    // Workers take High jobs first, then Normal, then Background. After
+    // starvationLimit jobs in a row that were not Background, a worker
+    // serves the lower lanes first once so they keep making progress.
+    enum class Priority { High, Normal, Background };
+
+    // Cores: worker i is pinned to cpus[i % cpus.size()].
+    // NumaNodes: workers are spread round-robin over the NUMA nodes and may
+    // run on any CPU of their node.
+    enum class Placement { None, Cores, NumaNodes };
+
+    struct Options {
+        Scheduling          scheduling = Scheduling::SharedQueue;
+        Placement           placement = Placement::None;
+        std::vector<int>    cpus;       // for Cores, every allowed CPU when empty
+        std::string         name = "worker";
+        std::size_t         starvationLimit = 16;
     };
 
-    WorkerPool(std::size_t numThreads) : stopped_(false) {
+    WorkerPool(std::size_t numThreads, Scheduling scheduling = Scheduling::SharedQueue)
+        : WorkerPool(numThreads, makeOptions(scheduling)) {}
+
+    WorkerPool(std::size_t numThreads, const Options& options)
+        : scheduling_(options.scheduling), starvationLimit_(std::max<std::size_t>(options.starvationLimit, 1)) {
+        if (scheduling_ == Scheduling::WorkStealing) {
+            for (std::size_t i = 0; i < numThreads; ++i) {
+                deques_.push_back(std::make_unique<WorkStealingDeque<IJob*>>());
+            }
+        }
+
+        std::vector<std::vector<int>> placements = placementsFor(options);
         for (std::size_t i = 0; i < numThreads; ++i) {
-            workers_.emplace_back(&WorkerPool::workerLoop, this);
+            std::vector<int> cpus = placements.empty() ? std::vector<int>() : placements[i % placements.size()];
+            std::string name = options.name + "-" + std::to_string(i);
+            workers_.emplace_back(&WorkerPool::workerLoop, this, i, std::move(name), std::move(cpus));
         }
     }
 
     ~WorkerPool() {
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            if (stopped_) return;
-            stopped_ = true;
+            stopping_ = true;
         }
         cv_.notify_all();
         for (auto &t : workers_) {
@@ -35,30 +86,413 @@ public:
         }
     }
 
-    void addJob(std::function<void()> func) {
-        queue_.push_back(IJob(std::move(func)));
-        cv_.notify_one();
+    // func is stored in the job itself when it fits in FTPP_JOB_INLINE_SIZE
+    // bytes, so small lambdas are queued without allocating.
+    template<typename TFunc>
+    void addJob(TFunc&& func, Priority priority = Priority::Normal) {
+        IJob* job = jobs_.construct(std::forward<TFunc>(func));
+        if (scheduling_ == Scheduling::SharedQueue) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                pushLane(priority, job);
+            }
+            cv_.notify_one();
+            return;
+        }
+
+        pending_.fetch_add(1, std::memory_order_seq_cst);
+        if (priority == Priority::Normal && currentPool_ == this) {
+            deques_[currentWorker_]->push(job);
+        } else {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pushLane(priority, job);
+        }
+        if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_one();
+        }
     }
 
+    std::size_t size() const { return workers_.size(); }
+
+    // Runs func on the pool and returns a handle to its result. Exceptions
+    // thrown by func are rethrown by TaskFuture::get().
+    template<typename TFunc>
+    auto submit(TFunc func, Priority priority = Priority::Normal) -> TaskFuture<std::invoke_result_t<TFunc>>;
+
 private:
-    void workerLoop() {
+    static constexpr std::size_t laneCount = 3;
+    static constexpr std::size_t injectBatch = 32;
+    static constexpr int spinRounds = 64;
+
+    inline static thread_local const WorkerPool* currentPool_ = nullptr;
+    inline static thread_local std::size_t currentWorker_ = 0;
+
+    static Options makeOptions(Scheduling scheduling) {
+        Options options;
+        options.scheduling = scheduling;
+        return options;
+    }
+
+    static std::vector<std::vector<int>> placementsFor(const Options& options) {
+        std::vector<std::vector<int>> placements;
+        if (options.placement == Placement::Cores) {
+            std::vector<int> cpus = options.cpus.empty() ? CpuTopology::allowedCpus() : options.cpus;
+            for (int cpu : cpus) placements.push_back({cpu});
+        } else if (options.placement == Placement::NumaNodes) {
+            placements = CpuTopology::numaNodes();
+        }
+        return placements;
+    }
+
+    static constexpr unsigned laneBit(Priority priority) {
+        return 1u << static_cast<unsigned>(priority);
+    }
+
+    static void runJob(IJob* job) {
+        try {
+            job->run();
+        } catch (...) {}
+    }
+
+    void workerLoop(std::size_t index, std::string name, std::vector<int> cpus) {
+        CpuTopology::nameCurrentThread(name);
+        if (!cpus.empty()) CpuTopology::pinCurrentThread(cpus);
+
+        currentPool_ = this;
+        currentWorker_ = index;
+        std::size_t streak = 0;
+
+        if (scheduling_ == Scheduling::SharedQueue) {
+            while (true) {
+                IJob* job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cv_.wait(lock, [this] {
+                        return stopping_ || readyLanes_.load(std::memory_order_relaxed) != 0;
+                    });
+                    job = takeLocked(streak);
+                }
+                if (!job) return;
+                runJob(job);
+                jobs_.destroy(job);
+            }
+        }
+
+        // Stealing workers spin a little before sleeping, a job pushed onto
+        // a deque is only announced through pending_.
+        uint64_t rng = 0x9E3779B97F4A7C15ULL * (index + 1);
+        std::vector<IJob*> batch;
+        int idle = 0;
         while (true) {
-            IJob job([]{});
+            IJob* job = findJob(index, rng, batch, streak);
+            if (job) {
+                idle = 0;
+                pending_.fetch_sub(1, std::memory_order_seq_cst);
+                runJob(job);
+                jobs_.destroy(job);
+                continue;
+            }
+
+            if (++idle < spinRounds) {
+                std::this_thread::yield();
+                continue;
+            }
+            idle = 0;
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            cv_.wait(lock, [this] {
+                return stopping_ || pending_.load(std::memory_order_seq_cst) > 0;
+            });
+            sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+            if (stopping_ && pending_.load(std::memory_order_seq_cst) == 0) return;
+        }
+    }
+
+    // The lanes and readyLanes_ are only changed with mutex_ held.
+    void pushLane(Priority priority, IJob* job) {
+        lanes_[static_cast<std::size_t>(priority)].push_back(job);
+        readyLanes_.store(readyLanes_.load(std::memory_order_relaxed) | laneBit(priority),
+                          std::memory_order_release);
+    }
+
+    IJob* popLane(Priority priority) {
+        std::deque<IJob*>& lane = lanes_[static_cast<std::size_t>(priority)];
+        if (lane.empty()) return nullptr;
+        IJob* job = lane.front();
+        lane.pop_front();
+        if (lane.empty()) {
+            readyLanes_.store(readyLanes_.load(std::memory_order_relaxed) & ~laneBit(priority),
+                              std::memory_order_release);
+        }
+        return job;
+    }
+
+    // Called with mutex_ held.
+    IJob* takeLocked(std::size_t& streak) {
+        if (streak >= starvationLimit_) {
+            streak = 0;
+            if (IJob* job = popLane(Priority::Background)) return job;
+            if (IJob* job = popLane(Priority::Normal)) return job;
+        }
+        if (IJob* job = popLane(Priority::High)) {
+            ++streak;
+            return job;
+        }
+        if (IJob* job = popLane(Priority::Normal)) {
+            ++streak;
+            return job;
+        }
+        if (IJob* job = popLane(Priority::Background)) {
+            streak = 0;
+            return job;
+        }
+        return nullptr;
+    }
+
+    // WorkStealing only. readyLanes_ is read without the lock to skip it
+    // when the lanes are empty, a stale bit costs one extra lock.
+    IJob* findJob(std::size_t index, uint64_t& rng, std::vector<IJob*>& batch, std::size_t& streak) {
+        unsigned ready = readyLanes_.load(std::memory_order_acquire);
+        unsigned lower = laneBit(Priority::Normal) | laneBit(Priority::Background);
+        if ((ready & laneBit(Priority::High)) || (streak >= starvationLimit_ && (ready & lower))) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (streak >= starvationLimit_) {
+                streak = 0;
+                if (IJob* job = popLane(Priority::Background)) return job;
+                if (IJob* job = popLane(Priority::Normal)) return job;
+            }
+            if (IJob* job = popLane(Priority::High)) {
+                ++streak;
+                return job;
+            }
+        }
+
+        if (std::optional<IJob*> job = deques_[index]->pop()) {
+            ++streak;
+            return *job;
+        }
+
+        if (ready & lower) {
+            batch.clear();
             {
-                std::unique_lock<std::mutex> lock(mutex_);
-                cv_.wait(lock, [&]{ return stopped_ || !queue_.empty(); });
-                if (stopped_ && queue_.empty()) return;
-                job = queue_.pop_front();
+                std::lock_guard<std::mutex> lock(mutex_);
+                while (batch.size() < injectBatch) {
+                    IJob* job = popLane(Priority::Normal);
+                    if (!job) break;
+                    batch.push_back(job);
+                }
+                if (batch.empty()) {
+                    if (IJob* job = popLane(Priority::Background)) {
+                        streak = 0;
+                        return job;
+                    }
+                }
+            }
+            if (!batch.empty()) {
+                for (std::size_t i = batch.size(); i-- > 1;) {
+                    deques_[index]->push(batch[i]);
+                }
+                ++streak;
+                return batch[0];
+            }
+        }
+
+        std::size_t count = deques_.size();
+        for (std::size_t attempt = 0; attempt < count; ++attempt) {
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+            std::size_t victim = static_cast<std::size_t>(rng % count);
+            if (victim == index) continue;
+            if (std::optional<IJob*> job = deques_[victim]->steal()) {
+                ++streak;
+                return *job;
             }
-            try {
-                job.run();
-            } catch (...) {}
         }
+        return nullptr;
     }
 
-    ThreadSafeQueue<IJob>       queue_;
+    Scheduling                  scheduling_;
+    std::size_t                 starvationLimit_;
     std::vector<std::thread>    workers_;
+
+    ConcurrentPool<IJob>        jobs_;
+    std::vector<std::unique_ptr<WorkStealingDeque<IJob*>>> deques_;
+
+    // One lock and one condition variable for every lane. readyLanes_ has
+    // a bit per non-empty lane.
     std::mutex                  mutex_;
     std::condition_variable     cv_;
-    bool                        stopped_;
+    std::deque<IJob*>           lanes_[laneCount];
+    std::atomic<unsigned>       readyLanes_{0};
+    bool                        stopping_ = false;
+
+    // WorkStealing only: queued jobs in lanes and deques, sleeping workers.
+    std::atomic<std::size_t>    pending_{0};
+    std::atomic<std::size_t>    sleepers_{0};
 };
+
+template<typename TType>
+class TaskFuture {
+public:
+    using Stored = std::conditional_t<std::is_void_v<TType>, std::monostate, TType>;
+
+    struct State {
+        std::mutex                          mutex;
+        std::condition_variable             cv;
+        bool                                ready = false;
+        std::optional<Stored>               value;
+        std::exception_ptr                  error;
+        std::vector<std::function<void()>>  continuations;
+
+        void finish(std::optional<Stored> p_value, std::exception_ptr p_error) {
+            std::vector<std::function<void()>> toRun;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                value = std::move(p_value);
+                error = p_error;
+                ready = true;
+                toRun.swap(continuations);
+            }
+            cv.notify_all();
+            for (auto& f : toRun) f();
+        }
+
+        // Runs f once the state is ready, inline if it already is.
+        void onReady(std::function<void()> f) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!ready) {
+                    continuations.push_back(std::move(f));
+                    return;
+                }
+            }
+            f();
+        }
+    };
+
+    TaskFuture() = default;
+    TaskFuture(std::shared_ptr<State> state, WorkerPool* pool)
+        : state_(std::move(state)), pool_(pool) {}
+
+    bool valid() const { return state_ != nullptr; }
+
+    bool ready() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->ready;
+    }
+
+    void wait() const {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->cv.wait(lock, [this] { return state_->ready; });
+    }
+
+    // Waits, then returns the result or rethrows the job's exception.
+    decltype(auto) get() const {
+        wait();
+        if (state_->error) std::rethrow_exception(state_->error);
+        if constexpr (!std::is_void_v<TType>) {
+            return static_cast<const TType&>(*state_->value);
+        }
+    }
+
+    // Schedules func on the pool once this result is ready. func receives
+    // the result (nothing for void). An exception skips func and is carried
+    // to the returned future.
+    template<typename TFunc>
+    auto then(TFunc func) const {
+        using Result = typename std::conditional_t<std::is_void_v<TType>,
+            std::invoke_result<TFunc>, std::invoke_result<TFunc, const Stored&>>::type;
+        auto next = std::make_shared<typename TaskFuture<Result>::State>();
+        std::shared_ptr<State> self = state_;
+        WorkerPool* pool = pool_;
+
+        state_->onReady([self, next, pool, func]() {
+            if (self->error) {
+                next->finish(std::nullopt, self->error);
+                return;
+            }
+            auto run = [self, next, func]() {
+                try {
+                    if constexpr (std::is_void_v<Result>) {
+                        if constexpr (std::is_void_v<TType>) func();
+                        else func(static_cast<const TType&>(*self->value));
+                        next->finish(std::monostate{}, nullptr);
+                    } else {
+                        if constexpr (std::is_void_v<TType>) next->finish(func(), nullptr);
+                        else next->finish(func(static_cast<const TType&>(*self->value)), nullptr);
+                    }
+                } catch (...) {
+                    next->finish(std::nullopt, std::current_exception());
+                }
+            };
+            if (pool) pool->addJob(run);
+            else run();
+        });
+        return TaskFuture<Result>(next, pool);
+    }
+
+private:
+    template<typename> friend class TaskFuture;
+    template<typename TOther>
+    friend TaskFuture<void> when_all(const std::vector<TaskFuture<TOther>>& futures);
+
+    std::shared_ptr<State>  state_;
+    WorkerPool*             pool_ = nullptr;
+};
+
+template<typename TFunc>
+auto WorkerPool::submit(TFunc func, Priority priority) -> TaskFuture<std::invoke_result_t<TFunc>> {
+    using Result = std::invoke_result_t<TFunc>;
+    auto state = std::make_shared<typename TaskFuture<Result>::State>();
+
+    addJob([state, func]() {
+        try {
+            if constexpr (std::is_void_v<Result>) {
+                func();
+                state->finish(std::monostate{}, nullptr);
+            } else {
+                state->finish(func(), nullptr);
+            }
+        } catch (...) {
+            state->finish(std::nullopt, std::current_exception());
+        }
+    }, priority);
+    return TaskFuture<Result>(state, this);
+}
+
+// Ready once every future is. Carries the first exception encountered, the
+// individual results stay available through each future's get().
+template<typename TType>
+TaskFuture<void> when_all(const std::vector<TaskFuture<TType>>& futures) {
+    auto joined = std::make_shared<TaskFuture<void>::State>();
+    WorkerPool* pool = futures.empty() ? nullptr : futures.front().pool_;
+    if (futures.empty()) {
+        joined->finish(std::monostate{}, nullptr);
+        return TaskFuture<void>(joined, pool);
+    }
+
+    struct Join {
+        std::atomic<std::size_t>    remaining;
+        std::mutex                  mutex;
+        std::exception_ptr          error;
+    };
+    auto join = std::make_shared<Join>();
+    join->remaining.store(futures.size());
+
+    for (const auto& future : futures) {
+        auto state = future.state_;
+        state->onReady([state, join, joined]() {
+            if (state->error) {
+                std::lock_guard<std::mutex> lock(join->mutex);
+                if (!join->error) join->error = state->error;
+            }
+            if (join->remaining.fetch_sub(1) == 1) {
+                joined->finish(std::monostate{}, join->error);
+            }
+        });
+    }
+    return TaskFuture<void>(joined, pool);
+}
@@ -0,0 +1,55 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include "binary_log.hpp"
+#include "thread.hpp"
+
+int main() {
+    // Formatted later on the background thread, keeping the Thread name
+    BinaryLog::instance().start();
+    Thread network("[network] ", []() {
+        for (int i = 1; i <= 2; ++i) {
+            THREAD_SAFE_LOG("request {} served in {} ms by {}", i, 1.5 * i, std::string("worker"));
+        }
+    });
+    network.start();
+    network.stop();
+    BinaryLog::instance().flush();
+    // Should output:
+    // "[network] request 1 served in 1.5 ms by worker"
+    // "[network] request 2 served in 3 ms by worker"
+    BinaryLog::instance().stop();
+
+    // Raw records to a file, formatted afterwards by the decoder
+    const char* path = "/tmp/ftpp_binary_log.bin";
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    BinaryLog::Options options;
+    options.output = BinaryLog::Output::Binary;
+    options.fd = fd;
+    BinaryLog::instance().start(options);
+
+    threadSafeCout.setPrefix("[main] ");
+    THREAD_SAFE_LOG("connected: {}, id {}, grade {}", true, -42, 'A');
+    THREAD_SAFE_LOG("bytes {} of \"{}\"", 1024u, "payload.bin");
+    THREAD_SAFE_LOG("body {}", std::string(300, 'x'));
+    BinaryLog::instance().stop();
+    ::close(fd);
+
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream decoded;
+    bool valid = BinaryLog::decode(in, decoded);
+    std::remove(path);
+
+    // Should output:
+    // "[main] connected: true, id -42, grade A"
+    // "[main] bytes 1024 of "payload.bin""
+    // "[main] body xx…xx…[truncated]" (the first 256 of the 300 x)
+    std::cout << decoded.str();
+    // Should output: "Decoded: yes"
+    std::cout << "Decoded: " << (valid ? "yes" : "no") << std::endl;
+
+    return 0;
+}
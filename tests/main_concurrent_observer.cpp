@@ -0,0 +1,67 @@
+#include "concurrent_observer.hpp"
+#include "server.hpp"
+#include "worker_pool.hpp"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+enum class EventType {
+    Moved,
+    Scored,
+    Quit
+};
+
+int main() {
+    // Notified from worker jobs while the main thread subscribes
+    ConcurrentObserver<EventType, int> scores;
+    std::atomic<long long> total{0};
+    scores.subscribe(EventType::Scored, [&total](const int& points) { total += points; });
+
+    {
+        WorkerPool pool(4);
+        std::vector<TaskFuture<void>> jobs;
+        for (int j = 0; j < 8; ++j) {
+            jobs.push_back(pool.submit([&scores]() {
+                for (int i = 0; i < 1000; ++i) scores.notify(EventType::Scored, 1);
+            }));
+        }
+        auto late = scores.subscribe(EventType::Scored, [](const int&) {});
+        when_all(jobs).wait();
+        scores.unsubscribe(late);
+    }
+    // Should output: "Points: 8000"
+    std::cout << "Points: " << total << std::endl;
+
+    // Deferred delivery on the Server loop thread
+    Server server;
+    ConcurrentObserver<EventType, int>::Options options;
+    ConcurrentObserver<EventType, int>* target = nullptr;
+    options.onPending = [&]() { server.post([&]() { target->flush(); }); };
+    ConcurrentObserver<EventType, int> moves(options);
+    target = &moves;
+
+    std::thread::id loopThread = std::this_thread::get_id();
+    bool onLoop = true;
+    int deliveries = 0;
+    int lastPosition = 0;
+    moves.subscribe(EventType::Moved, [&](const int& position) {
+        onLoop = onLoop && std::this_thread::get_id() == loopThread;
+        ++deliveries;
+        lastPosition = position;
+    });
+
+    std::thread producer([&moves]() {
+        for (int i = 1; i <= 100; ++i) moves.post(EventType::Moved, i);
+    });
+    producer.join();
+    // Should output: "Delivered before update: 0"
+    std::cout << "Delivered before update: " << deliveries << std::endl;
+
+    server.update();
+    // Should output: "Coalesced into 1 delivery at position 100 on the loop thread: yes"
+    std::cout << "Coalesced into " << deliveries << " delivery at position " << lastPosition
+              << " on the loop thread: " << (onLoop ? "yes" : "no") << std::endl;
+
+    return 0;
+}
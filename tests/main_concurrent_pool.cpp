@@ -0,0 +1,51 @@
+#include "concurrent_pool.hpp"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+class TestObject {
+public:
+    int value;
+    TestObject(int p_value) : value(p_value) { ++alive; }
+    ~TestObject() { --alive; }
+
+    static std::atomic<int> alive;
+};
+
+std::atomic<int> TestObject::alive{0};
+
+int main() {
+    ConcurrentPool<TestObject> myPool;
+    std::atomic<long long> sum{0};
+
+    // Four threads acquiring and releasing concurrently
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&myPool, &sum, t]() {
+            for (int i = 0; i < 10000; ++i) {
+                auto obj = myPool.acquire(t);
+                sum += obj->value;
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    // Should output: "Sum: 60000"
+    std::cout << "Sum: " << sum << std::endl;
+
+    // Objects acquired on one thread and released on another
+    std::vector<ConcurrentPool<TestObject>::Object> handoff;
+    for (int i = 0; i < 500; ++i) {
+        handoff.push_back(myPool.acquire(i));
+    }
+    std::thread releaser([&handoff]() { handoff.clear(); });
+    releaser.join();
+    // Should output: "Alive after cross-thread release: 0"
+    std::cout << "Alive after cross-thread release: " << TestObject::alive << std::endl;
+
+    auto kept = myPool.acquire(42);
+    // Should output: "Kept value: 42"
+    std::cout << "Kept value: " << kept->value << std::endl;
+
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include "data_buffer.hpp" // Assuming your DataBuffer is defined in this header
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <exception>
 
 class TestObject {
@@ -51,5 +52,14 @@ int main() {
         std::cout << "Caught exception: " << e.what() << std::endl;  // This line should be executed
     }
 
+    // A string_view is written as its text, not as a pointer
+    DataBuffer textBuffer;
+    std::string source = "viewed text";
+    textBuffer << std::string_view(source).substr(0, 6);
+    source = "overwritten";
+    std::string text;
+    textBuffer >> text;
+    std::cout << "From string_view: " << text << std::endl;  // Should print: "From string_view: viewed"
+
     return 0;
 }
@@ -0,0 +1,67 @@
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "lock_free_queue.hpp"
+
+int main() {
+    LockFreeQueue<int> myQueue(4);
+
+    myQueue.push_back(10);
+    myQueue.push_back(20);
+    // Should output: "Popped value: 10"
+    std::cout << "Popped value: " << myQueue.pop_front() << std::endl;
+    // Should output: "Popped value: 20"
+    std::cout << "Popped value: " << myQueue.pop_front() << std::endl;
+    try {
+        myQueue.pop_front();
+    } catch (const std::runtime_error& e) {
+        // Should output: "pop on empty queue"
+        std::cout << e.what() << std::endl;
+    }
+
+    for (int i = 0; i < 4; ++i) myQueue.push_back(i);
+    // Should output: "try_push on full queue: false"
+    std::cout << "try_push on full queue: " << std::boolalpha << myQueue.try_push(4) << std::endl;
+
+    // Move-only elements
+    LockFreeQueue<std::unique_ptr<int>> ptrQueue(8);
+    ptrQueue.push_back(std::make_unique<int>(42));
+    std::unique_ptr<int> ptr = ptrQueue.pop_front();
+    // Should output: "Moved value: 42"
+    std::cout << "Moved value: " << *ptr << std::endl;
+
+    // Two producers and two consumers
+    LockFreeQueue<int> shared(1024);
+    std::atomic<long long> sum{0};
+    std::atomic<int> consumed{0};
+    const int perProducer = 100000;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 2; ++p) {
+        threads.emplace_back([&shared]() {
+            for (int i = 1; i <= perProducer; ++i) {
+                while (!shared.try_push(i)) std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < 2; ++c) {
+        threads.emplace_back([&]() {
+            int value;
+            while (consumed.load() < 2 * perProducer) {
+                if (shared.try_pop(value)) {
+                    sum += value;
+                    ++consumed;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    // Should output: "Sum: 10000100000"
+    std::cout << "Sum: " << sum << std::endl;
+
+    return 0;
+}
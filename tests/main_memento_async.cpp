@@ -0,0 +1,75 @@
+#include "memento.hpp"
+#include "snapshot_store.hpp"
+#include "worker_pool.hpp"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Keeps its bulk state copy-on-write so saveAsync() only takes a reference
+class Terrain : public Memento {
+    friend class Memento;
+
+public:
+    std::string name = "valley";
+    CopyOnWrite<std::vector<int>> heights{std::vector<int>(10000, 7)};
+
+private:
+    void _saveToSnapshot(Snapshot& snapshotToFill) const override {
+        write(snapshotToFill, name, *heights);
+    }
+
+    void _loadFromSnapshot(Snapshot& snapshot) override {
+        uint32_t count;
+        snapshot >> name >> count;
+        std::vector<int>& h = heights.write();
+        h.resize(count);
+        for (int& v : h) snapshot >> v;
+    }
+
+    Capture _captureForSave() const override {
+        std::string capturedName = name;
+        std::shared_ptr<const std::vector<int>> capturedHeights = heights.share();
+        return [capturedName, capturedHeights](Snapshot& out) {
+            write(out, capturedName, *capturedHeights);
+        };
+    }
+
+    static void write(Snapshot& out, const std::string& name, const std::vector<int>& heights) {
+        out << name << static_cast<uint32_t>(heights.size());
+        for (int v : heights) out << v;
+    }
+};
+
+int main() {
+    WorkerPool pool(2);
+    Terrain terrain;
+
+    auto pending = terrain.saveAsync(pool, Memento::Compression::Fast);
+    // Keep simulating while the pool serializes the captured state
+    terrain.heights.write()[0] = 99;
+    terrain.name = "crater";
+
+    Memento::Snapshot saved = pending.get();
+    // Should output: "Compressed to less than a tenth: yes"
+    std::size_t raw = terrain.save().size();
+    std::cout << "Compressed to less than a tenth: " << (saved.isCompressed() && saved.size() * 10 < raw ? "yes" : "no") << std::endl;
+
+    // Compressed snapshots go to disk as they are
+    const char* path = "/tmp/ftpp_memento_async.bin";
+    std::remove(path);
+    {
+        SnapshotStore store(path);
+        store.append(saved);
+    }
+    SnapshotStore store(path);
+    Terrain restored;
+    store.restoreLatest(restored);
+    // Should output: "Restored valley, first height 7"
+    std::cout << "Restored " << restored.name << ", first height " << (*restored.heights)[0] << std::endl;
+    // Should output: "Live terrain: crater, first height 99"
+    std::cout << "Live terrain: " << terrain.name << ", first height " << (*terrain.heights)[0] << std::endl;
+    std::remove(path);
+
+    return 0;
+}
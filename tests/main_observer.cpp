@@ -1,5 +1,6 @@
 #include "observer.hpp"
 #include <iostream>
+#include <string>
 
 enum class EventType {
     EVENT_ONE,
@@ -41,5 +42,33 @@ int main() {
     std::cout << "Notify EVENT_THREE" << std::endl;
     observer.notify(EventType::EVENT_THREE);  // Output: None, as there are no subscribers
 
+    // Typed payloads and unsubscribe through the returned id
+    struct Damage {
+        std::string target;
+        int amount;
+    };
+    Observer<EventType, Damage> combat;
+    auto logger = combat.subscribe(EventType::EVENT_ONE, [](const Damage& d) {
+        std::cout << d.target << " took " << d.amount << " damage" << std::endl;
+    });
+    // Removes itself while the event is being delivered
+    Observer<EventType, Damage>::SubscriptionId once = 0;
+    once = combat.subscribe(EventType::EVENT_ONE, [&combat, &once](const Damage& d) {
+        std::cout << "First blood on " << d.target << std::endl;
+        combat.unsubscribe(once);
+    });
+
+    std::cout << "Notify EVENT_ONE with payload" << std::endl;
+    combat.notify(EventType::EVENT_ONE, Damage{"goblin", 12});
+    // Output:
+    // "goblin took 12 damage"
+    // "First blood on goblin"
+    combat.notify(EventType::EVENT_ONE, Damage{"orc", 7});  // Output: "orc took 7 damage"
+
+    combat.unsubscribe(logger);
+    combat.notify(EventType::EVENT_ONE, Damage{"troll", 3});  // Output: None
+    // Output: "Subscribers left: 0"
+    std::cout << "Subscribers left: " << combat.subscriberCount(EventType::EVENT_ONE) << std::endl;
+
     return 0;
 }
@@ -0,0 +1,56 @@
+#include "parallel_algorithms.hpp"
+#include "ivector3.hpp"
+#include <vector>
+#include "perlin_noise_2D.hpp"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+int main() {
+    WorkerPool pool(4);
+
+    // Sample a 512x512 noise grid, one row-major index per cell
+    const std::size_t side = 512;
+    PerlinNoise2D noise(42);
+    std::vector<float> grid(side * side);
+    parallel_for(pool, 0, grid.size(), [&](std::size_t i) {
+        grid[i] = noise.sample((i % side) * 0.05f, (i / side) * 0.05f);
+    });
+
+    bool same = true;
+    for (std::size_t i = 0; i < grid.size(); ++i) {
+        same = same && grid[i] == noise.sample((i % side) * 0.05f, (i / side) * 0.05f);
+    }
+    // Should output: "Grid matches serial: yes"
+    std::cout << "Grid matches serial: " << (same ? "yes" : "no") << std::endl;
+
+    // Transform a vector of IVector3 and sum their components
+    std::vector<IVector3<int>> points(100000);
+    parallel_for(pool, 0, points.size(), [&](std::size_t i) {
+        points[i] = IVector3<int>(static_cast<int>(i % 3), 1, 2);
+    });
+    long total = parallel_reduce(pool, 0, points.size(), 0L,
+        [&](std::size_t i) { return static_cast<long>(points[i].x + points[i].y + points[i].z); },
+        [](long a, long b) { return a + b; });
+    // Should output: "Component sum: 399999"
+    std::cout << "Component sum: " << total << std::endl;
+
+    std::vector<int> values(200000);
+    std::mt19937 gen(7);
+    for (int& v : values) v = static_cast<int>(gen() % 1000000);
+    parallel_sort(pool, values.begin(), values.end());
+    // Should output: "Sorted: yes"
+    std::cout << "Sorted: " << (std::is_sorted(values.begin(), values.end()) ? "yes" : "no") << std::endl;
+
+    try {
+        parallel_for(pool, 0, 1000, [](std::size_t i) {
+            if (i == 500) throw std::runtime_error("index 500 failed");
+        });
+    } catch (const std::runtime_error& e) {
+        // Should output: "Caught exception: index 500 failed"
+        std::cout << "Caught exception: " << e.what() << std::endl;
+    }
+
+    return 0;
+}
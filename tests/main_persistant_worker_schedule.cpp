@@ -0,0 +1,42 @@
+#include "persistent_worker.hpp"
+#include "thread_safe_iostream.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+int main() {
+    PersistentWorker worker;
+    std::atomic<int> fast{0};
+    std::atomic<int> slow{0};
+    std::atomic<int> once{0};
+
+    worker.addTask("Fast", [&]() { ++fast; }, std::chrono::milliseconds(50));
+    worker.addTask("Slow", [&]() { ++slow; }, std::chrono::milliseconds(200));
+    worker.addTaskAt("Once", [&]() { ++once; },
+                     PersistentWorker::Clock::now() + std::chrono::milliseconds(300));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    worker.removeTask("Fast");
+    worker.removeTask("Slow");
+
+    // Should output: "Fast ran more often than Slow: yes"
+    threadSafeCout << "Fast ran more often than Slow: " << (fast > 2 * slow ? "yes" : "no") << std::endl;
+    // Should output: "One-shot ran 1 time(s)"
+    threadSafeCout << "One-shot ran " << once << " time(s)" << std::endl;
+
+    // A task removed while it runs is not rescheduled
+    std::atomic<bool> running{false};
+    std::atomic<int> runs{0};
+    worker.addTask("Long", [&]() {
+        ++runs;
+        running = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }, std::chrono::milliseconds(10));
+    while (!running) std::this_thread::yield();
+    worker.removeTask("Long");
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    // Should output: "Removed while running, ran 1 time(s)"
+    threadSafeCout << "Removed while running, ran " << runs << " time(s)" << std::endl;
+
+    return 0;
+}
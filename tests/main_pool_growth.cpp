@@ -0,0 +1,48 @@
+#include "pool.hpp"
+#include <iostream>
+#include <vector>
+
+class TestObject {
+public:
+    int value;
+    TestObject(int p_value) : value(p_value) {}
+};
+
+int main() {
+    // A pool of 2 slots that adds 4 more whenever it runs out
+    Pool<TestObject> myPool(4);
+    myPool.resize(2);
+
+    Pool<TestObject>::Object first = myPool.acquire(1);
+    TestObject* firstAddress = &*first;
+
+    std::vector<Pool<TestObject>::Object> others;
+    for (int i = 2; i <= 10; ++i) {
+        others.push_back(myPool.acquire(i));
+    }
+    // Should output: "Capacity after growth: 10"
+    std::cout << "Capacity after growth: " << myPool.size() << std::endl;
+
+    myPool.resize(100);
+    // Should output: "First object did not move: yes"
+    std::cout << "First object did not move: " << (firstAddress == &*first ? "yes" : "no") << std::endl;
+    std::cout << "First object value: " << first->value << std::endl;
+
+    others.clear();
+    // Only the trailing, fully free chunks are released
+    myPool.resize(0);
+    // Should output: "Capacity after shrink: 2"
+    std::cout << "Capacity after shrink: " << myPool.size() << std::endl;
+
+    Pool<TestObject> fixedPool;
+    fixedPool.resize(1);
+    Pool<TestObject>::Object only = fixedPool.acquire(0);
+    try {
+        Pool<TestObject>::Object extra = fixedPool.acquire(1);
+    } catch (const std::bad_alloc& e) {
+        // Should output: "Fixed pool exhausted: std::bad_alloc"
+        std::cout << "Fixed pool exhausted: " << e.what() << std::endl;
+    }
+
+    return 0;
+}
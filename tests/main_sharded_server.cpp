@@ -0,0 +1,57 @@
+#include "network.hpp"
+#include "thread_safe_iostream.hpp"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main() {
+    ShardedServer server(4);
+
+    // Handlers run on the loop thread owning the client
+    server.defineAction(1, [&server](long long& clientID, const Message& msg) {
+        int value;
+        msg >> value;
+
+        Message replyMsg(3);
+        replyMsg << (value * 2);
+        server.sendTo(replyMsg, clientID);
+    });
+
+    server.start(8081);
+
+    const int clientCount = 8;
+    std::vector<int> replies(clientCount, 0);
+    std::vector<std::thread> clients;
+
+    for (int i = 0; i < clientCount; ++i) {
+        clients.emplace_back([i, &replies]() {
+            Client client;
+            client.defineAction(3, [i, &replies](const Message& msg) {
+                msg >> replies[i];
+            });
+            client.connect("localhost", 8081);
+
+            Message message(1);
+            message << (i + 1);
+            client.send(message);
+
+            for (int tries = 0; tries < 200 && replies[i] == 0; ++tries) {
+                client.update();
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        });
+    }
+
+    for (auto& t : clients) {
+        t.join();
+    }
+
+    // Should print the doubled value for every client, in order
+    for (int i = 0; i < clientCount; ++i) {
+        threadSafeCout << "Client " << i << " sent " << (i + 1) << ", received " << replies[i] << std::endl;
+    }
+
+    server.stop();
+    return 0;
+}
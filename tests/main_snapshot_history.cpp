@@ -0,0 +1,69 @@
+#include "snapshot_history.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+class World : public Memento {
+    friend class Memento;
+
+public:
+    std::string name = "arena";
+    std::vector<float> positions = std::vector<float>(1000, 0.0f);
+    int tick = 0;
+
+    void step(void) {
+        ++tick;
+        // Only a handful of entities move each tick
+        for (std::size_t i = tick % 10; i < positions.size(); i += 100) {
+            positions[i] += 1.0f;
+        }
+    }
+
+private:
+    void _saveToSnapshot(Snapshot& snapshotToFill) const override {
+        snapshotToFill << name << tick << static_cast<uint32_t>(positions.size());
+        for (float p : positions) snapshotToFill << p;
+    }
+
+    void _loadFromSnapshot(Snapshot& snapshot) override {
+        uint32_t count;
+        snapshot >> name >> tick >> count;
+        positions.resize(count);
+        for (float& p : positions) snapshot >> p;
+    }
+};
+
+int main() {
+    World world;
+    SnapshotHistory history(8);
+
+    for (int t = 0; t < 40; ++t) {
+        history.record(world);
+        world.step();
+    }
+    std::size_t full = world.save().size() * history.size();
+
+    // Should output: "Entries: 40, keyframes every 8"
+    std::cout << "Entries: " << history.size() << ", keyframes every 8" << std::endl;
+    // Should output: "Delta smaller than a tenth of a keyframe: yes"
+    std::cout << "Delta smaller than a tenth of a keyframe: "
+              << (history.entryBytes(13) * 10 < history.entryBytes(8) ? "yes" : "no") << std::endl;
+    // Should output: "Stored less than a quarter of full copies: yes"
+    std::cout << "Stored less than a quarter of full copies: " << (history.storedBytes() * 4 < full ? "yes" : "no") << std::endl;
+
+    // Roll back to tick 13 (keyframe 8 plus 5 deltas)
+    history.restore(world, 13);
+    // Should output: "Restored tick 13, position[3] = 2"
+    std::cout << "Restored tick " << world.tick << ", position[3] = " << world.positions[3] << std::endl;
+
+    // Record a different future from there
+    history.truncate(13);
+    world.name = "arena-2";
+    history.record(world);
+    history.restore(world, 0);
+    history.restore(world, 14);
+    // Should output: "Entries: 15, latest arena-2 at tick 13"
+    std::cout << "Entries: " << history.size() << ", latest " << world.name << " at tick " << world.tick << std::endl;
+
+    return 0;
+}
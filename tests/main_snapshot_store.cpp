@@ -0,0 +1,71 @@
+#include "snapshot_store.hpp"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+class Player : public Memento {
+    friend class Memento;
+
+public:
+    std::string name;
+    int level = 0;
+    double health = 0;
+
+private:
+    void _saveToSnapshot(Snapshot& snapshotToFill) const override {
+        snapshotToFill << name << level << health;
+    }
+
+    void _loadFromSnapshot(Snapshot& snapshot) override {
+        snapshot >> name >> level >> health;
+    }
+};
+
+int main() {
+    const char* path = "/tmp/ftpp_snapshot_store.bin";
+    std::remove(path);
+
+    Player player;
+    player.name = "Ada";
+    {
+        SnapshotStore::Options options;
+        options.sync = false;
+        SnapshotStore store(path, options);
+        for (int level = 1; level <= 3; ++level) {
+            player.level = level;
+            player.health = 10.0 * level;
+            store.append(player);
+        }
+        // Should output: "Stored 3 snapshots"
+        std::cout << "Stored " << store.size() << " snapshots" << std::endl;
+    }
+
+    // A crash in the middle of the next append leaves half a record behind
+    {
+        int fd = ::open(path, O_WRONLY | O_APPEND);
+        const char torn[] = "PANS\x01\x02";
+        ssize_t written = ::write(fd, torn, sizeof(torn));
+        (void)written;
+        ::close(fd);
+    }
+
+    // After a restart the index is rebuilt and the torn tail dropped
+    SnapshotStore store(path);
+    Player restored;
+    store.restoreLatest(restored);
+    // Should output: "Recovered 3 snapshots, latest: Ada level 3 health 30"
+    std::cout << "Recovered " << store.size() << " snapshots, latest: " << restored.name
+              << " level " << restored.level << " health " << restored.health << std::endl;
+
+    // Snapshots read straight from the mapping
+    Memento::Snapshot view = store.load(0);
+    // Should output: "First snapshot is a view: yes"
+    std::cout << "First snapshot is a view: " << (view.isView() ? "yes" : "no") << std::endl;
+    restored.load(view);
+    // Should output: "Level 1 health 10"
+    std::cout << "Level " << restored.level << " health " << restored.health << std::endl;
+
+    std::remove(path);
+    return 0;
+}
@@ -51,6 +51,20 @@ int main() {
         std::cout << "Exception caught: " << e.what() << std::endl;  // Handle state not found
     }
 
+    // Same machine with a dense transition table
+    sm.compile();
+    sm.update();  // Should print: "System is running."
+    sm.transitionTo(State::Paused);  // Should print: "Transitioning from Running to Paused."
+    // Should print: "Idle reachable from Paused: no"
+    std::cout << "Idle reachable from Paused: " << (sm.tryTransitionTo(State::Idle) ? "yes" : "no") << std::endl;
+    sm.update();  // Should print: "System is paused."
+
+    // Registering after compile() keeps the table in use
+    sm.addTransition(State::Paused, State::Stopped, [] { std::cout << "Transitioning from Paused to Stopped." << std::endl; });
+    sm.transitionTo(State::Stopped);  // Should print: "Transitioning from Paused to Stopped."
+    // Should print: "Still compiled: yes"
+    std::cout << "Still compiled: " << (sm.isCompiled() ? "yes" : "no") << std::endl;
+
     return 0;
 }
 
@@ -0,0 +1,54 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include "thread_safe_iostream.hpp"
+
+int main() {
+    // Batch every statement into a log file instead of stdout
+    const char* path = "/tmp/ftpp_async_log.txt";
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    LogWriter::AsyncOptions options;
+    options.fd = fd;
+    options.batchBytes = 16 * 1024;
+    options.flushInterval = std::chrono::milliseconds(2);
+    LogWriter::instance().enableAsync(options);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t]() {
+            threadSafeCout.setPrefix("[Thread " + std::to_string(t) + "] ");
+            for (int i = 0; i < 1000; ++i) {
+                threadSafeCout << "Number: " << i << std::endl;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    LogWriter::instance().flush();
+    LogWriter::instance().disableAsync();
+    ::close(fd);
+
+    std::ifstream in(path);
+    std::string line;
+    int lines = 0;
+    bool intact = true;
+    while (std::getline(in, line)) {
+        ++lines;
+        intact = intact && line.rfind("[Thread ", 0) == 0 && line.find("] Number: ") == 9;
+    }
+    std::remove(path);
+
+    // Should output: "Lines: 4000, intact: yes"
+    std::cout << "Lines: " << lines << ", intact: " << (intact ? "yes" : "no") << std::endl;
+
+    // Back in synchronous mode, statements go straight to std::cout
+    // Should output: "Synchronous again"
+    threadSafeCout << "Synchronous again" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "thread_safe_queue.hpp"
+
+int main() {
+    ThreadSafeQueue<int> myQueue;
+
+    // The consumer blocks until the producer pushes
+    std::thread consumer([&myQueue]() {
+        std::optional<int> value = myQueue.wait_pop();
+        std::cout << "Waited for value: " << *value << std::endl;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    myQueue.push_back(10);
+    consumer.join();
+
+    // Should output: "Timed out: true"
+    std::optional<int> nothing = myQueue.wait_pop(std::chrono::milliseconds(20));
+    std::cout << "Timed out: " << std::boolalpha << !nothing.has_value() << std::endl;
+
+    // Batches go in and out under a single lock
+    std::vector<int> batch = {1, 2, 3, 4, 5};
+    myQueue.push_bulk(batch.begin(), batch.end());
+    std::vector<int> drained;
+    std::size_t count = myQueue.pop_bulk(drained, 3);
+    // Should output: "Drained 3: 1 2 3"
+    std::cout << "Drained " << count << ":";
+    for (int v : drained) std::cout << " " << v;
+    std::cout << std::endl;
+
+    // Closing wakes waiters, remaining elements are still delivered
+    myQueue.close();
+    while (std::optional<int> value = myQueue.wait_pop()) {
+        std::cout << "Remaining after close: " << *value << std::endl;
+    }
+
+    try {
+        myQueue.push_back(6);
+    } catch (const std::runtime_error& e) {
+        // Should output: "push on closed queue"
+        std::cout << e.what() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "server.hpp"
+#include "timer_wheel.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+int main() {
+    using namespace std::chrono;
+
+    // Driven by a synthetic clock, timers fire in deadline order across levels
+    TimerWheel::Clock::time_point start = TimerWheel::Clock::now();
+    TimerWheel wheel(milliseconds(1), start);
+    std::string fired;
+    wheel.schedule(hours(6), [&]() { fired += " 6h"; });
+    wheel.schedule(seconds(90), [&]() { fired += " 90s"; });
+    wheel.schedule(milliseconds(5), [&]() { fired += " 5ms"; });
+    TimerWheel::TimerId cancelled = wheel.schedule(milliseconds(200), [&]() { fired += " 200ms"; });
+    wheel.schedule(milliseconds(70), [&]() { fired += " 70ms"; });
+    wheel.cancel(cancelled);
+
+    // Should output: "Next timeout: 5 ms"
+    std::cout << "Next timeout: " << wheel.timeoutMs(start) << " ms" << std::endl;
+
+    wheel.advance(start + seconds(100));
+    wheel.advance(start + hours(7));
+    // Should output: "Fired: 5ms 70ms 90s 6h"
+    std::cout << "Fired:" << fired << std::endl;
+    // Should output: "Pending timers: 0"
+    std::cout << "Pending timers: " << wheel.size() << std::endl;
+
+    // Owned by the server loop, the next deadline bounds update(-1)
+    Server server;
+    int beats = 0;
+    bool timedOut = false;
+    std::function<void()> heartbeat = [&]() {
+        if (++beats < 3) server.addTimer(milliseconds(20), heartbeat);
+    };
+    server.addTimer(milliseconds(20), heartbeat);
+    TimerWheel::TimerId idle = server.addTimer(milliseconds(30), [&]() { timedOut = true; });
+    server.cancelTimer(idle);
+
+    auto begin = steady_clock::now();
+    while (beats < 3) {
+        server.update(-1);
+    }
+    auto elapsed = duration_cast<milliseconds>(steady_clock::now() - begin).count();
+
+    // Should output: "Heartbeats: 3, idle timeout fired: no"
+    std::cout << "Heartbeats: " << beats << ", idle timeout fired: " << (timedOut ? "yes" : "no") << std::endl;
+    // Should output: "Took about 60 ms: yes"
+    std::cout << "Took about 60 ms: " << (elapsed >= 60 && elapsed < 200 ? "yes" : "no") << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "worker_pool.hpp"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main() {
+    WorkerPool pool(4);
+
+    // Two independent stages run in parallel, a third joins them
+    TaskFuture<int> left  = pool.submit([]() { return 20; });
+    TaskFuture<int> right = pool.submit([]() { return 22; });
+
+    TaskFuture<int> sum = when_all(std::vector<TaskFuture<int>>{left, right})
+        .then([left, right]() { return left.get() + right.get(); });
+
+    TaskFuture<std::string> label = sum.then([](const int& value) {
+        return "Answer: " + std::to_string(value);
+    });
+
+    // Should output: "Answer: 42"
+    std::cout << label.get() << std::endl;
+
+    // Exceptions skip the continuation and reach the caller
+    TaskFuture<int> failing = pool.submit([]() -> int {
+        throw std::runtime_error("stage failed");
+    });
+    TaskFuture<int> skipped = failing.then([](const int& value) {
+        std::cout << "This should not be printed" << std::endl;
+        return value;
+    });
+
+    try {
+        skipped.get();
+    } catch (const std::runtime_error& e) {
+        // Should output: "Caught exception: stage failed"
+        std::cout << "Caught exception: " << e.what() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "worker_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <pthread.h>
+
+int main() {
+    WorkerPool::Options options;
+    options.name = "render";
+    options.placement = WorkerPool::Placement::Cores;
+    options.starvationLimit = 4;
+    WorkerPool pool(1, options);
+
+    std::mutex mutex;
+    std::string order;
+    std::atomic<bool> gate{false};
+    std::atomic<int> done{0};
+
+    // Hold the only worker while the lanes fill up
+    pool.addJob([&]() {
+        char name[16] = {};
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        // Should output: "Worker name: render-0"
+        std::cout << "Worker name: " << name << std::endl;
+        while (!gate) std::this_thread::yield();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto record = [&](char tag) {
+        return [&, tag]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order += tag;
+            ++done;
+        };
+    };
+    for (int i = 0; i < 10; ++i) pool.addJob(record('B'), WorkerPool::Priority::Background);
+    for (int i = 0; i < 10; ++i) pool.addJob(record('N'));
+    for (int i = 0; i < 3; ++i)  pool.addJob(record('H'), WorkerPool::Priority::High);
+
+    gate = true;
+    while (done < 23) std::this_thread::yield();
+
+    // Should output: "First three: HHH"
+    std::cout << "First three: " << order.substr(0, 3) << std::endl;
+    // Should output: "Background ran before normal lane drained: yes"
+    std::cout << "Background ran before normal lane drained: "
+              << (order.find('B') < order.rfind('N') ? "yes" : "no") << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,32 @@
+#include "worker_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+int main() {
+    std::atomic<int> done{0};
+    {
+        WorkerPool pool(4, WorkerPool::Scheduling::WorkStealing);
+
+        // Every root job fans out 10 children from inside the pool,
+        // which land on the local deque of the worker running the root
+        for (int root = 0; root < 10; ++root) {
+            pool.addJob([&pool, &done]() {
+                for (int child = 0; child < 10; ++child) {
+                    pool.addJob([&done]() { ++done; });
+                }
+                ++done;
+            });
+        }
+
+        while (done.load() < 110) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Should output: "Jobs executed: 110"
+    std::cout << "Jobs executed: " << done.load() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+#include "binary_log.hpp"
+#include <fstream>
+#include <iostream>
+
+// Formats a log written with BinaryLog::Output::Binary.
+// Usage: log_decoder <file>
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "usage: " << argv[0] << " <binary log>" << std::endl;
+        return 1;
+    }
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::cerr << "cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    if (!BinaryLog::decode(in, std::cout)) {
+        std::cerr << argv[1] << ": not a binary log or truncated" << std::endl;
+        return 1;
+    }
+    return 0;
+}